@@ -7,6 +7,29 @@
 #include "utilities/utilities.h"
 #include <random>
 #include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+/*
+ * The least number of data points worth giving a thread of its own.
+ */
+static const arma::uword SAMPLES_PER_THREAD = 1 << 16;
+
+/*
+ * The weight of a new observation at which every count is scaled back
+ * down, well before the counts could overflow.
+ */
+static const double MAXIMUM_WEIGHT = 1e100;
+
+/*
+ * How far a distribution given to a noisy-MAX factor may stray from
+ * summing to one, to allow for rounding.
+ */
+static const double NOISY_TOLERANCE = 1e-6;
 
 BayesianNetwork::BayesianNetwork() = default;
 BayesianNetwork::BayesianNetwork(arma::uword states) : numStates{states} {}
@@ -19,416 +42,2005 @@ BayesianNetwork::BayesianNetwork(arma::uword states) : numStates{states} {}
  * factor was added. False will be returned if there already
  * is a factor with the provided name in the network.
  */
-bool BayesianNetwork::add(std::string factorName) {
-    return graph.add(factorName);
-}
-
-bool BayesianNetwork::record(std::string factor1, std::string factor2, arma::uword factor1State, arma::uword factor2State, double factor2Probability) {
-
-    arma::mat values;
-    arma::mat* probabilities = graph.getWeight(factor1, factor2);
+bool BayesianNetwork::add(const std::string& factorName) {
 
-    if (probabilities != NULL) {
-        values = *probabilities;
-    } else {
-        values = arma::mat(numStates, numStates, arma::fill::zeros);
-    }
+    nodeId id;
+    return add(factorName, numStates, id);
 
-    values(factor2State, factor1State) = factor2Probability;
+}
 
-    bool result = graph.connect(factor1, factor2, values);
-    delete probabilities;
+bool BayesianNetwork::add(std::string&& factorName) {
 
-    return result;
+    nodeId id;
+    return add(std::move(factorName), id);
 
 }
 
-bool BayesianNetwork::record(std::string factor1, std::string factor2, arma::uword factor1State, arma::uword factor2State) {
+/**
+ * Method for adding a node to the network and getting hold of
+ * its handle. Operations taking handles skip the name lookup
+ * entirely, which is what should be used in tight loops.
+ *
+ * @param factorName A descriptive name for the factor.
+ * @param id Set to the handle of the factor, whether it was just
+ * added or already present.
+ * @return False if there already is a factor with the provided
+ * name in the network.
+ */
+bool BayesianNetwork::add(const std::string& factorName, nodeId& id) {
+    return add(factorName, numStates, id);
+}
 
-    arma::mat values;
-    arma::mat* probabilities = graph.getWeight(factor1, factor2);
+bool BayesianNetwork::add(std::string&& factorName, nodeId& id) {
 
-    if (probabilities != NULL) {
-        values = *probabilities;
-    } else {
-        values = arma::mat(numStates, numStates, arma::fill::zeros);
+    if (!graph.add(std::move(factorName), id)) {
+        return false;
     }
 
-    ++values(factor2State, factor1State);
+    cardinalities.push_back(numStates);
 
-    bool result = graph.connect(factor1, factor2, values);
-    delete probabilities;
-
-    return result;
+    return true;
 
 }
 
+/**
+ * Method for adding a node that takes a number of states other than
+ * the default of the network. Every table involving the factor is
+ * sized to exactly the number of states given here.
+ *
+ * @param factorName A descriptive name for the factor.
+ * @param states The number of states the factor can take.
+ * @return False if there already is a factor with the provided
+ * name in the network.
+ */
+bool BayesianNetwork::add(const std::string& factorName, arma::uword states) {
 
-bool BayesianNetwork::erase(std::string factor1, std::string factor2, arma::uword factor1State, arma::uword factor2State) {
-
-    arma::mat values;
-    arma::mat* probabilities = graph.getWeight(factor1, factor2);
+    nodeId id;
+    return add(factorName, states, id);
 
-    if (probabilities == NULL) {
-        return false;
-    }
+}
 
-    values = *probabilities;
+bool BayesianNetwork::add(const std::string& factorName, arma::uword states, nodeId& id) {
 
-    if (values(factor2State, factor1State) == 0) {
+    if (!graph.add(factorName, id)) {
         return false;
     }
 
-    --values(factor2State, factor1State);
-
-    bool result = graph.connect(factor1, factor2, values);
-    delete probabilities;
+    cardinalities.push_back(states);
 
-    return result;
+    return true;
 
 }
 
 /**
- * Method for getting the probabilities for all the states of a hidden node,
- * given that a series of visible nodes take certain values. The thought is
- * that this will be used when there has just been measurements of visible
- * nodes and the relevant hidden probabilities, given those measurements,
- * have to be established.
+ * Method for looking up the handle of a factor.
  *
- * @param hidden The name of the hidden node.
- * @param visibleStates A mapping of visible node keys to their states. This
- * will most likely be recently measured states.
- * @return A matrix of probabilities where each row represents a visible node.
+ * @param factorName The name of the factor.
+ * @param id Set to the handle of the factor if it exists.
+ * @return False if there is no factor with the provided name.
  */
-arma::mat BayesianNetwork::get(std::string hidden, std::map<std::string, arma::uword> visibleStates) {
-
-    arma::mat currentStates;
-
-    for (auto const& it : visibleStates) {
-
-        arma::mat* probabilities = graph.getWeight(hidden, it.first);
-        currentStates = arma::join_cols(currentStates, probabilities->row(it.second));
+bool BayesianNetwork::getId(const std::string& factorName, nodeId& id) const {
+    return graph.getId(factorName, id);
+}
 
-        delete probabilities;
+/*
+ * The table of counts the edge from parent to child refers to, or NULL
+ * if the two are not connected.
+ */
+CountTable* BayesianNetwork::findCounts(nodeId parent, nodeId child) {
 
-    }
+    const tableId* id = graph.findWeight(parent, child);
 
-    return currentStates;
+    return id == NULL ? NULL : &edgeTables.get(*id);
 
 }
 
-/**
- * Utility method to generate data associated with a hidden node.
- *
- * @param thetaHidden A list of probabilities of the hidden node taking certain
- * values. Each probability describes the value indicated by its position in
- * the list. Thus, the list {0.38, 0.62} would indicate that there is a 38%
- * probability that the hidden node takes the value 0 and a 62% chance that it
- * takes the value 1.
- * @param samples The number of data points to generate.
- * @return A set of generated values.
- */
-arma::rowvec BayesianNetwork::simulateHiddenData(const std::vector<double> thetaHidden, const int samples) {
-
-    std::discrete_distribution<> dist(thetaHidden.begin(), thetaHidden.end()); // Create a custom distribution by providing an iterator to the list.
-    std::mt19937 eng(std::time(0)); // Initiate a mersenne twister.
-
-    arma::rowvec dataHidden(samples);
+const CountTable* BayesianNetwork::findCounts(nodeId parent, nodeId child) const {
 
-    for (int i = 0; i < samples; ++i) { // Generate the data points
-        dataHidden(i) = dist(eng);
-    }
+    const tableId* id = graph.findWeight(parent, child);
 
-    return dataHidden;
+    return id == NULL ? NULL : &edgeTables.get(*id);
 
 }
 
-arma::rowvec BayesianNetwork::simulateHiddenData(arma::rowvec thetaHidden, int samples) {
-
-    std::discrete_distribution<> dist(thetaHidden.begin(), thetaHidden.end()); // Create a custom distribution by providing an iterator to the list.
-    std::mt19937 eng(std::time(0)); // Initiate a mersenne twister.
+/*
+ * A new table of zero counts, windowed like every other table.
+ */
+tableId BayesianNetwork::createCounts(arma::uword rows, arma::uword cols) {
 
-    arma::rowvec dataHidden(samples);
+    tableId id = edgeTables.create(rows, cols);
 
-    for (int i = 0; i < samples; ++i) { // Generate the data points
-        dataHidden(i) = dist(eng);
+    if (windowBuckets > 0) {
+        edgeTables.get(id).setWindow(windowBuckets);
     }
 
-    return dataHidden;
+    return id;
 
 }
 
-arma::rowvec BayesianNetwork::simulateHiddenData(arma::mat thetaHidden) {
+/*
+ * The weight an observation recorded now is counted with in a table.
+ * Tables holding assigned values are not decayed, so observations in
+ * them always count as one.
+ */
+double BayesianNetwork::weightOf(const CountTable& counts) const {
+    return counts.isAssigned() ? 1 : countWeight;
+}
 
-    std::mt19937 eng(std::time(0)); // Initiate a mersenne twister.
-    arma::rowvec dataHidden(thetaHidden.n_rows);
+/*
+ * Connects parent to child through a new table of zero counts, one row
+ * per state of the child and one column per state of the parent.
+ */
+bool BayesianNetwork::connectCounts(nodeId parent, nodeId child) {
 
-    int counter = 0;
-    thetaHidden.each_row([&counter, &dataHidden, &eng] (rowvec& row) {
+    if (parent.index >= cardinalities.size() || child.index >= cardinalities.size()) {
+        return false;
+    }
 
-        std::discrete_distribution<> dist(row.begin(), row.end()); // Create a custom distribution by providing an iterator to the row.
-        dataHidden(counter++) = dist(eng);
+    tableId id = createCounts(cardinalities[child.index], cardinalities[parent.index]);
 
-    });
+    if (!graph.connect(parent, child, id)) {
+        edgeTables.release(id);
+        return false;
+    }
 
-    return dataHidden;
+    return true;
 
 }
 
 /**
- * Utility method to simulate visible data based on a set of hidden data.
- * Requires data measured from a hidden node to determine which probability
- * distribution should be used to generate the visible data.
+ * Method for setting up the structure of a network in one go. Every
+ * factor is added and every pair of factors connected with an empty
+ * table of counts, with storage for all of it reserved up front.
+ * Considerably faster than adding factors and recording observations
+ * one at a time when building large networks.
  *
- * @param hiddenNode The key required to access the hidden node.
- * @param hiddenData The data of the hidden node.
- * @param samples The number of data points to generate.
- * @return A mapping of visible node keys to lists of generated data.
+ * @param factorNames The names of the factors to add. Names already
+ * in the network are skipped, new factors take the default number of
+ * states.
+ * @param connections Pairs of factor names, the first factor in each
+ * pair being the one the second depends on.
+ * @return False if a connection refers to an unknown factor, in which
+ * case it is skipped, or if the connections would make the network
+ * cyclic, in which case none of them are made.
  */
-std::map<std::string, arma::rowvec> BayesianNetwork::simulateVisibleData(const std::string hiddenNode,
-                                                                         const arma::rowvec hiddenData,
-                                                                         const int samples) {
-
-    std::map<std::string, arma::mat> weights = graph.getWeights(hiddenNode); // Get all visible nodes that the hidden node is associated with, and their weights.
-    std::map<std::string, arma::rowvec> dataVisible;
+bool BayesianNetwork::loadStructure(const std::vector<std::string>& factorNames,
+                                    const std::vector<std::pair<std::string, std::string>>& connections) {
 
-    std::random_device rd;
-    std::mt19937 eng(rd());
+    bool complete = graph.build(factorNames, std::vector<std::tuple<std::string, std::string, tableId>>());
 
-    for (auto &&node : weights) { // For each visible node.
+    cardinalities.resize(graph.size(), numStates);
 
-        arma::rowvec simulatedDataPoints(samples);
+    std::vector<std::pair<nodeId, nodeId>> pairs;
+    pairs.reserve(connections.size());
 
-        for (int i = 0; i < hiddenData.size(); ++i) { // For each hidden data point.
+    for (auto const& it : connections) {
 
-            double dataPoint = hiddenData(i);
+        nodeId parent, child;
 
-            /*
-             * The weight of each edge between the hidden and the
-             * visible nodes is a matrix of probabilities. The value
-             * of the hidden node is taken as a positional indicator
-             * of which column of the matrix to look at.
-             */
-            arma::colvec col = node.second.col(dataPoint); // Pick out the column.
+        if (!graph.getId(it.first, parent) || !graph.getId(it.second, child)) {
 
-            std::discrete_distribution<> dist(col.begin(), col.end()); // Create a distribution from the set of probabilities contained in the column by providing an iterator.
+            complete = false;
+            continue;
 
-            int simulatedDataPoint = dist(eng); // Generate the value.
-            simulatedDataPoints(i) = simulatedDataPoint; // Put the generated visible value in the exact same position as the hidden value. This positional correspondence is what indicates causal or temporal correspondence.
+        }
 
+        /*
+         * Building over an existing edge would replace its table, so
+         * edges already in the network keep the one they have.
+         */
+        if (graph.findWeight(parent, child) == NULL) {
+            pairs.emplace_back(parent, child);
         }
+    }
 
-        dataVisible.insert(std::pair<std::string, arma::rowvec>(node.first, simulatedDataPoints)); // Insert the simulated data points under the key provided.
+    std::sort(pairs.begin(), pairs.end(), [] (const std::pair<nodeId, nodeId>& first, const std::pair<nodeId, nodeId>& second) {
+        return first.first.index != second.first.index ? first.first.index < second.first.index
+             : first.second.index < second.second.index;
+    });
+
+    pairs.erase(std::unique(pairs.begin(), pairs.end(), [] (const std::pair<nodeId, nodeId>& first, const std::pair<nodeId, nodeId>& second) {
+        return first.first.index == second.first.index && first.second.index == second.second.index;
+    }), pairs.end());
 
+    /*
+     * Checked up front so that no tables are created for a structure
+     * that would be rejected.
+     */
+    if (!graph.canConnect(pairs)) {
+        return false;
     }
 
-    return dataVisible;
+    std::vector<std::tuple<nodeId, nodeId, tableId>> edges;
+    edges.reserve(pairs.size());
 
-}
+    for (auto const& it : pairs) {
+        edges.emplace_back(it.first, it.second, createCounts(cardinalities[it.second.index], cardinalities[it.first.index]));
+    }
 
-std::map<std::string, arma::rowvec> BayesianNetwork::simulateVisibleData(std::map<std::string, arma::mat> thetaVisible,
-                                                                          std::string hiddenNode,
-                                                                          arma::rowvec hiddenData,
-                                                                          int samples) {
+    return graph.build(std::move(edges)) && complete;
 
-    std::map<std::string, arma::rowvec> dataVisible;
+}
 
-    std::random_device rd;
-    std::mt19937 eng(rd());
+bool BayesianNetwork::record(const std::string& factor1, const std::string& factor2, arma::uword factor1State, arma::uword factor2State, double factor2Probability) {
 
-    for (auto &&node : thetaVisible) { // For each visible node.
+    nodeId id1, id2;
 
-        arma::rowvec simulatedDataPoints(samples);
+    if (!graph.getId(factor1, id1) || !graph.getId(factor2, id2)) {
+        return false;
+    }
 
-        for (int i = 0; i < hiddenData.size(); ++i) { // For each hidden data point.
+    return record(id1, id2, factor1State, factor2State, factor2Probability);
 
-            double dataPoint = hiddenData(i);
+}
 
-            /*
-             * The weight of each edge between the hidden and the
-             * visible nodes is a matrix of probabilities. The value
-             * of the hidden node is taken as a positional indicator
-             * of which column of the matrix to look at.
-             */
-            arma::colvec col = node.second.col(dataPoint); // Pick out the column.
+bool BayesianNetwork::record(nodeId factor1, nodeId factor2, arma::uword factor1State, arma::uword factor2State, double factor2Probability) {
 
-            std::discrete_distribution<> dist(col.begin(), col.end()); // Create a distribution from the set of probabilities contained in the column by providing an iterator.
+    auto assign = [factor1State, factor2State, factor2Probability] (CountTable& values) {
+        values.set(factor2State, factor1State, factor2Probability);
+    };
 
-            int simulatedDataPoint = dist(eng); // Generate the value.
-            simulatedDataPoints(i) = simulatedDataPoint; // Put the generated visible value in the exact same position as the hidden value. This positional correspondence is what indicates causal or temporal correspondence.
+    CountTable* values = findCounts(factor1, factor2);
 
+    if (values == NULL) {
+
+        if (!connectCounts(factor1, factor2)) {
+            return false;
         }
 
-        dataVisible.insert(std::pair<std::string, arma::rowvec>(node.first, simulatedDataPoints)); // Insert the simulated data points under the key provided.
+        values = findCounts(factor1, factor2);
 
     }
-    return dataVisible;
 
-}
+    assign(*values);
+
+    return true;
 
-arma::uword BayesianNetwork::getNumStates() const {
-    return numStates;
 }
 
-/**
- * Method to compute the probability of a hidden node taking certain values,
- * based on a set of data.
- *
- * @param dataHidden The measured values that the hidden node has taken.
- * @return The probability that the hidden node takes a certain value. The
- * position of each probability indicates which value it describes. 0.38
- * in position 0 would therefore indicate that there is a 38% probability
- * that the hidden node takes the value 0.
- */
-arma::rowvec BayesianNetwork::computeThetaHidden(const arma::rowvec dataHidden) {
+bool BayesianNetwork::record(const std::string& factor1, const std::string& factor2, arma::uword factor1State, arma::uword factor2State) {
 
-    arma::rowvec histogram(numStates, arma::fill::zeros);
+    nodeId id1, id2;
 
-    for (auto &&dataPoint : dataHidden) {
-        ++histogram(dataPoint);
+    if (!graph.getId(factor1, id1) || !graph.getId(factor2, id2)) {
+        return false;
     }
 
-    return histogram / dataHidden.size();
+    return record(id1, id2, factor1State, factor2State);
 
 }
 
-/**
- * Method to compute the probabilities of a series of visible nodes taking
- * certain values, given that a hidden node takes certain values, based on
- * lists of gathered data. Correspondence between hidden and visible data
- * is indicated by the values having the same position in the respective
- * lists of gathered data. Thus, if one measurement has been made and the
- * hidden node measured 1 when a visible node measured 2, the values would
- * both be placed in position 0.
- *
- * @param dataHidden A list of values that the hidden node has taken.
- * @param dataVisible A map of nodes with corresponding lists of values
- * that those nodes have taken.
- * @return The probabilities of the visible nodes taking certain values, given
- * that the hidden node has taken certain values.
- */
-std::map<std::string, arma::mat>
-BayesianNetwork::computeThetaVisible(arma::rowvec dataHidden, std::map<std::string, arma::rowvec> dataVisible) {
+bool BayesianNetwork::record(nodeId factor1, nodeId factor2, arma::uword factor1State, arma::uword factor2State) {
 
-    std::map<std::string, arma::mat> histogramByNode;
+    /*
+     * The count is incremented where it is stored, so recording an
+     * observation on an existing edge neither copies the matrix nor
+     * allocates.
+     */
+    auto increment = [this, factor1State, factor2State] (CountTable& values) {
+        values.add(factor2State, factor1State, weightOf(values));
+    };
 
-    for (auto &&visibleFactor : dataVisible) { // For each visible node.
+    CountTable* values = findCounts(factor1, factor2);
 
-        arma::mat histogram(numStates, numStates, arma::fill::zeros); // Initialize a matrix to hold the counts of each measured value.
+    if (values == NULL) {
 
-        /*
-         * Create a histogram as a first step to calculate
-         * the probabilities. The value of the hidden factor
-         * determines which column to increment in, the visible
-         * factor which row.
-         */
-        for (int i = 0; i < dataHidden.size(); ++i) {
+        if (!connectCounts(factor1, factor2)) {
+            return false;
+        }
 
-            double hiddenDataPoint = dataHidden(i);
-            double visibleDataPoint = visibleFactor.second(i);
+        values = findCounts(factor1, factor2);
 
-            ++histogram(visibleDataPoint, hiddenDataPoint);
+    }
 
-        }
+    increment(*values);
 
-        histogramByNode.insert(std::pair<std::string, arma::mat>(visibleFactor.first, histogram));
+    return true;
 
-    }
+}
 
-    for (auto &&item : histogramByNode) {
+bool BayesianNetwork::recordBatch(const std::string& factor1, const std::string& factor2,
+                                  const arma::uword* factor1States, const arma::uword* factor2States, size_t n) {
 
-        /*
-         * Divide each column, element-wise, with the total number
-         * of data points in the column to get the probability.
-         */
-        item.second.each_col([&dataHidden] (arma::vec& column) {
-            column /= (float) arma::accu(column);
-        });
+    nodeId id1, id2;
 
-        /*
-         * Fix points where division by zero has occurred.
-         */
-        item.second.transform([] (double val) {
-            return std::isnan(val) ? double(0) : val;
-        });
+    if (!graph.getId(factor1, id1) || !graph.getId(factor2, id2)) {
+        return false;
     }
 
-    return histogramByNode;
+    return recordBatch(id1, id2, factor1States, factor2States, n);
 
 }
 
-std::map<std::string, arma::mat> BayesianNetwork::computeThetaVisible(std::string hiddenNode) {
+/**
+ * Method for counting a batch of observations of two factors, connecting
+ * them if they are not already. The edge is looked up once for the whole
+ * batch and the counts added straight into its table, which is far
+ * cheaper than recording the observations one at a time.
+ *
+ * @param factor1 The factor the other depends on.
+ * @param factor2 The factor that depends on the other.
+ * @param factor1States The state of the first factor in each observation.
+ * @param factor2States The state of the second factor in each observation.
+ * @param n The number of observations.
+ * @return False if a state is out of range, in which case nothing is
+ * counted, or if the connection would make the network cyclic.
+ */
+bool BayesianNetwork::recordBatch(nodeId factor1, nodeId factor2,
+                                  const arma::uword* factor1States, const arma::uword* factor2States, size_t n) {
+
+    CountTable* values = findCounts(factor1, factor2);
 
-    std::map<std::string, arma::mat> histogramByNode = graph.getWeights(hiddenNode);
+    if (values == NULL) {
 
-    for (auto &&item : histogramByNode) {
+        if (!connectCounts(factor1, factor2)) {
+            return false;
+        }
 
-        /*
-         * Divide each column, element-wise, with the total number
-         * of data points in the column to get the probability.
-         */
-        item.second.each_col([] (arma::vec& column) {
-            column /= (float) arma::accu(column);
-        });
+        values = findCounts(factor1, factor2);
 
-        /*
-         * Fix points where division by zero has occurred.
-         */
-        item.second.transform([] (double val) {
-            return std::isnan(val) ? double(0) : val;
-        });
     }
 
-    return histogramByNode;
+    return values->increment(factor2States, factor1States, n, weightOf(*values));
 
 }
 
-arma::rowvec BayesianNetwork::imputeHiddenNode(arma::rowvec thetaHidden, arma::mat thetaVisible) {
+bool BayesianNetwork::recordBatch(const std::vector<std::string>& factorNames, const arma::umat& states) {
 
-    arma::rowvec final = arma::rowvec(thetaHidden.size());
+    std::vector<nodeId> factors(factorNames.size());
 
-    for (arma::uword i = 0; i < thetaVisible.n_cols; ++i) {
+    for (size_t i = 0; i < factorNames.size(); ++i) {
+        if (!graph.getId(factorNames[i], factors[i])) {
+            return false;
+        }
+    }
 
-        arma::mat copy = thetaVisible;
-        copy.shed_col(i);
+    return recordBatch(factors, states);
 
-        arma::mat toBeSummed = arma::mat(1, thetaHidden.size());
+}
 
-        /*
-         * Use everything that is not the current hidden probability
-         * as a collective "not true" value but be sure to use the
-         * theta hidden associated with each non-true column.
-         */
-        for (arma::uword j = 0; j < copy.n_cols; ++j) {
+/**
+ * Method for counting a batch of observations of several factors at
+ * once, on every edge between them. Each edge is looked up once for the
+ * whole batch. Edges are not created here, so the structure is expected
+ * to be in place already, for instance through loadStructure.
+ *
+ * @param factors The factors observed.
+ * @param states One row per observation and one column per factor, in
+ * the order the factors are given in.
+ * @return False if the number of columns does not match the number of
+ * factors or a state is out of range, in which case nothing is counted.
+ */
+bool BayesianNetwork::recordBatch(const std::vector<nodeId>& factors, const arma::umat& states) {
 
-            arma::mat column = arma::trans(copy.col(j));
+    if (states.n_cols != factors.size()) {
+        return false;
+    }
 
-            double correctThetaHidden = thetaHidden(((i + 1) + j) % thetaHidden.size());
-            arma::mat probVis0Unnorm = correctThetaHidden * arma::prod(column, 1);
+    for (arma::uword col = 0; col < states.n_cols; ++col) {
 
-            toBeSummed.col(j) = probVis0Unnorm;
-            
+        if (factors[col].index >= cardinalities.size()) {
+            return false;
         }
 
-        /*
-         * Use the current hidden probability as the sole "true value".
-         * Then repeat the process so that every hidden probability
-         * has been treated as the true value.
-         */
-        arma::mat column = arma::trans(thetaVisible.col(i));
+        const arma::uword* column = states.colptr(col);
+        const arma::uword limit = cardinalities[factors[col].index];
 
-        arma::mat probVis1Unnorm = thetaHidden(i) * arma::prod(column, 1); // i will never be greater than the number of hidden states, since the columns in thetaVisible in fact represent those states.
-        toBeSummed.tail_cols(1) = probVis1Unnorm;
+        for (arma::uword row = 0; row < states.n_rows; ++row) {
+            if (column[row] >= limit) {
+                return false;
+            }
+        }
+    }
 
-        arma::mat hidden = probVis1Unnorm / sum(toBeSummed, 1); // sum rows
+    /*
+     * Maps each node to its column in the batch, so that the children
+     * of each factor are matched without a lookup per pair of factors.
+     */
+    const arma::uword absent = states.n_cols;
+    std::vector<arma::uword> columns(graph.size(), absent);
 
-        final.col(i) = hidden;
+    for (arma::uword col = 0; col < states.n_cols; ++col) {
+        columns[factors[col].index] = col;
+    }
 
+    for (arma::uword col = 0; col < states.n_cols; ++col) {
+        graph.forEachChild(factors[col], [this, &states, &columns, absent, col] (nodeId child, tableId table) {
+            if (columns[child.index] != absent) {
+                CountTable& counts = edgeTables.get(table);
+                counts.increment(states.colptr(columns[child.index]), states.colptr(col), states.n_rows, weightOf(counts));
+            }
+        });
     }
 
-    return final;
+    return true;
 
 }
 
 
+bool BayesianNetwork::erase(const std::string& factor1, const std::string& factor2, arma::uword factor1State, arma::uword factor2State) {
+
+    nodeId id1, id2;
+
+    if (!graph.getId(factor1, id1) || !graph.getId(factor2, id2)) {
+        return false;
+    }
+
+    return erase(id1, id2, factor1State, factor2State);
+
+}
+
+/**
+ * Method for taking back an observation of two factors.
+ *
+ * While observations are decayed, the table only holds the decayed sum
+ * of each cell, not when each observation in it was recorded, so erase
+ * takes back the weight of an observation recorded now. That is exact
+ * for observations recorded since the last tick. Once an observation is
+ * older it is worth less than that, so erasing it fails and leaves the
+ * count as it is, unless the cell holds enough older observations to
+ * make up the weight of a new one, in which case they are what is
+ * taken back.
+ *
+ * @return False if the factors are not connected, or the cell holds
+ * less than the weight of one observation recorded now.
+ */
+bool BayesianNetwork::erase(nodeId factor1, nodeId factor2, arma::uword factor1State, arma::uword factor2State) {
+
+    CountTable* values = findCounts(factor1, factor2);
+
+    return values != NULL && values->remove(factor2State, factor1State, weightOf(*values));
+
+}
+
+bool BayesianNetwork::tie(const std::string& parent, const std::string& child, const std::string& sharedParent, const std::string& sharedChild) {
+
+    nodeId parentId, childId, sharedParentId, sharedChildId;
+
+    if (!graph.getId(parent, parentId) || !graph.getId(child, childId) ||
+        !graph.getId(sharedParent, sharedParentId) || !graph.getId(sharedChild, sharedChildId)) {
+        return false;
+    }
+
+    return tie(parentId, childId, sharedParentId, sharedChildId);
+
+}
+
+/**
+ * Method for tying the parameters of one edge to those of another, so
+ * that both refer to the same table of counts. Observations recorded
+ * through either edge, or any other edge tied to the same table, count
+ * towards all of them, which lets repeated structure such as the time
+ * slices of a dynamic network learn from every slice at once and keeps
+ * a single copy of the table in memory. The two factors are connected
+ * if they are not already. Counts recorded on the edge before it was
+ * tied are dropped.
+ *
+ * @param parent The factor the other depends on.
+ * @param child The factor that depends on the other.
+ * @param sharedParent The parent of the edge whose table is shared.
+ * @param sharedChild The child of the edge whose table is shared.
+ * @return False if the edge to share is not in the network, if the
+ * factors do not have the same number of states as those of that edge,
+ * or if the connection would make the network cyclic.
+ */
+bool BayesianNetwork::tie(nodeId parent, nodeId child, nodeId sharedParent, nodeId sharedChild) {
+
+    const tableId* found = graph.findWeight(sharedParent, sharedChild);
+
+    if (found == NULL) {
+        return false;
+    }
+
+    tableId shared = *found;
+    const CountTable& counts = edgeTables.get(shared);
+
+    if (counts.getNumRows() != getNumStates(child) || counts.getNumCols() != getNumStates(parent)) {
+        return false;
+    }
+
+    tableId* existing = graph.findWeight(parent, child);
+
+    if (existing != NULL) {
+
+        if (existing->index != shared.index) {
+            edgeTables.retain(shared);
+            edgeTables.release(*existing);
+            *existing = shared;
+        }
+
+        return true;
+
+    }
+
+    edgeTables.retain(shared);
+
+    if (!graph.connect(parent, child, shared)) {
+        edgeTables.release(shared);
+        return false;
+    }
+
+    return true;
+
+}
+
+/**
+ * @return The number of distinct tables of counts held by the network.
+ * Edges tied to each other count once.
+ */
+size_t BayesianNetwork::getNumTables() const {
+    return edgeTables.size();
+}
+
+/**
+ * Method for giving a factor a conditional probability table over any
+ * number of parents, instead of one pairwise table per edge. Each
+ * parent is connected to the factor if it is not already.
+ *
+ * @param factorName The name of the factor.
+ * @param parentNames The names of the parents, in the order their
+ * states will be given when recording.
+ * @return False if a factor is unknown, the factor already has a table
+ * over its parents, or a connection would make the network cyclic. No
+ * parent is connected in that case.
+ */
+bool BayesianNetwork::setParents(const std::string& factorName, const std::vector<std::string>& parentNames) {
+
+    nodeId factor;
+    std::vector<nodeId> parents;
+    std::vector<arma::uword> parentStates;
+
+    if (!graph.getId(factorName, factor) || getTable(factor) != NULL || !connectParents(factor, parentNames, parents)) {
+        return false;
+    }
+
+    for (auto const& it : parents) {
+        parentStates.push_back(cardinalities[it.index]);
+    }
+
+    if (tables.size() <= factor.index) {
+        tables.resize(factor.index + 1);
+    }
+
+    tables[factor.index] = ConditionalProbabilityTable(cardinalities[factor.index], parentStates);
+
+    return true;
+
+}
+
+/*
+ * Looks up each parent by name and connects it to the factor unless
+ * it already is. Every name and connection is checked first, so that
+ * nothing is connected if any of them fails.
+ */
+bool BayesianNetwork::connectParents(nodeId factor, const std::vector<std::string>& parentNames, std::vector<nodeId>& parents) {
+
+    nodeId parent;
+    std::vector<std::pair<nodeId, nodeId>> missing;
+
+    for (auto const& it : parentNames) {
+
+        if (!graph.getId(it, parent)) {
+            return false;
+        }
+
+        if (graph.findWeight(parent, factor) == NULL) {
+            missing.emplace_back(parent, factor);
+        }
+
+        parents.push_back(parent);
+
+    }
+
+    if (!graph.canConnect(missing)) {
+        return false;
+    }
+
+    for (auto const& it : missing) {
+        if (graph.findWeight(it.first, it.second) == NULL && !connectCounts(it.first, it.second)) {
+            return false;
+        }
+    }
+
+    return true;
+
+}
+
+bool BayesianNetwork::record(const std::string& factorName, arma::uword factorState, const std::vector<arma::uword>& parentStates) {
+
+    nodeId factor;
+
+    if (!graph.getId(factorName, factor)) {
+        return false;
+    }
+
+    return record(factor, factorState, parentStates);
+
+}
+
+/**
+ * Method for recording an observation of a factor together with the
+ * states of all its parents.
+ *
+ * @param factor The handle of the factor.
+ * @param factorState The observed state of the factor.
+ * @param parentStates The observed state of each parent, in the order
+ * the parents were given to setParents.
+ * @return False if the factor has no table or a state is out of range,
+ * or if observations are being decayed or windowed. Tables over several
+ * parents hold plain counts with no notion of when they were recorded.
+ */
+bool BayesianNetwork::record(nodeId factor, arma::uword factorState, const std::vector<arma::uword>& parentStates) {
+
+    ConditionalProbabilityTable* table = findTable(factor, factorState, parentStates);
+
+    if (table == NULL || halfLife > 0 || windowBuckets > 0) {
+        return false;
+    }
+
+    table->record(factorState, parentStates.data(), 1);
+
+    return true;
+
+}
+
+bool BayesianNetwork::erase(const std::string& factorName, arma::uword factorState, const std::vector<arma::uword>& parentStates) {
+
+    nodeId factor;
+
+    if (!graph.getId(factorName, factor)) {
+        return false;
+    }
+
+    return erase(factor, factorState, parentStates);
+
+}
+
+/**
+ * Method for taking back an observation recorded with the states of all
+ * the parents of a factor. Fails while observations are being decayed
+ * or windowed, as recording does.
+ */
+bool BayesianNetwork::erase(nodeId factor, arma::uword factorState, const std::vector<arma::uword>& parentStates) {
+
+    ConditionalProbabilityTable* table = findTable(factor, factorState, parentStates);
+
+    return table != NULL && halfLife == 0 && windowBuckets == 0 && table->erase(factorState, parentStates.data());
+
+}
+
+ConditionalProbabilityTable* BayesianNetwork::findTable(nodeId factor, arma::uword factorState, const std::vector<arma::uword>& parentStates) {
+
+    if (factor.index >= tables.size() || tables[factor.index].empty()) {
+        return NULL;
+    }
+
+    ConditionalProbabilityTable& table = tables[factor.index];
+
+    if (factorState >= table.getNumStates() || parentStates.size() != table.getNumParents()) {
+        return NULL;
+    }
+
+    for (arma::uword i = 0; i < parentStates.size(); ++i) {
+
+        if (parentStates[i] >= table.getParentStates()[i]) {
+            return NULL;
+        }
+    }
+
+    return &table;
+
+}
+
+/**
+ * Method for getting the table of counts recorded for a factor.
+ *
+ * @return The table, or NULL if setParents has not been called for
+ * the factor.
+ */
+const ConditionalProbabilityTable* BayesianNetwork::getTable(nodeId factor) const {
+
+    if (factor.index >= tables.size() || tables[factor.index].empty()) {
+        return NULL;
+    }
+
+    return &tables[factor.index];
+
+}
+
+/**
+ * Method to compute the probabilities of a factor taking each of its
+ * states given every assignment of states to its parents, based on
+ * the observations recorded so far.
+ *
+ * @param factorName The name of the factor.
+ * @return The normalized table, or an empty table if the factor has
+ * no parents set.
+ */
+ConditionalProbabilityTable BayesianNetwork::computeThetaConditional(const std::string& factorName) const {
+
+    nodeId factor;
+
+    if (!graph.getId(factorName, factor) || getTable(factor) == NULL) {
+        return ConditionalProbabilityTable();
+    }
+
+    ConditionalProbabilityTable probabilities = tables[factor.index];
+    probabilities.normalize();
+
+    return probabilities;
+
+}
+
+/**
+ * Method for letting a factor depend on its parents through the noisy-MAX
+ * model instead of a full table. How each parent pushes the factor is
+ * the table on the edge from the parent to the factor, set with record,
+ * where the column for state 0 of the parent should put all probability
+ * on state 0 of the factor. Parents are connected to the factor if they
+ * are not already.
+ *
+ * @param factorName The name of the factor.
+ * @param parentNames The names of the parents, in the order their
+ * states will be given when computing the distribution of the factor.
+ * @param leak The probability of the factor taking each of its states
+ * when every parent is in state 0.
+ * @return False if a factor is unknown, the leak is not a distribution
+ * over the states of the factor, or a connection would make the network
+ * cyclic.
+ */
+bool BayesianNetwork::setNoisyMax(const std::string& factorName, const std::vector<std::string>& parentNames, const arma::vec& leak) {
+
+    nodeId factor;
+    std::vector<nodeId> parents;
+
+    if (!graph.getId(factorName, factor) || leak.n_elem != cardinalities[factor.index] ||
+        leak.min() < 0 || leak.max() > 1 || !(std::abs(arma::accu(leak) - 1) <= NOISY_TOLERANCE) ||
+        !connectParents(factor, parentNames, parents)) {
+        return false;
+    }
+
+    if (noisyMaxes.size() <= factor.index) {
+        noisyMaxes.resize(factor.index + 1);
+    }
+
+    noisyMaxes[factor.index] = NoisyMax(parents, leak);
+
+    return true;
+
+}
+
+/**
+ * Method for setting up a binary factor as the noisy-OR of binary
+ * parents. Each parent in state 1 sets the factor to 1 with its own
+ * probability, independently of the other parents. The probabilities
+ * are written to the tables on the edges from the parents, so an edge
+ * whose table is tied to other edges is refused rather than have the
+ * values show up on those edges as well.
+ *
+ * @param factorName The name of the factor.
+ * @param parentNames The names of the parents.
+ * @param causeProbabilities The probability of each parent setting the
+ * factor to 1 on its own.
+ * @param leak The probability of the factor being 1 with every parent
+ * in state 0.
+ * @return False if a factor is unknown or not binary, there is not one
+ * probability per parent, a probability is not between 0 and 1, an edge
+ * from a parent has a table shared with other edges, or a connection
+ * would make the network cyclic.
+ */
+bool BayesianNetwork::setNoisyOr(const std::string& factorName, const std::vector<std::string>& parentNames,
+                                 const std::vector<double>& causeProbabilities, double leak) {
+
+    nodeId factor, parent;
+
+    if (parentNames.size() != causeProbabilities.size() || getNumStates(factorName) != 2 || !(leak >= 0 && leak <= 1)) {
+        return false;
+    }
+
+    graph.getId(factorName, factor);
+
+    for (arma::uword i = 0; i < parentNames.size(); ++i) {
+
+        double probability = causeProbabilities[i];
+
+        if (getNumStates(parentNames[i]) != 2 || !(probability >= 0 && probability <= 1)) {
+            return false;
+        }
+
+        graph.getId(parentNames[i], parent);
+
+        const tableId* existing = graph.findWeight(parent, factor);
+
+        if (existing != NULL && edgeTables.getReferences(*existing) > 1) {
+            return false;
+        }
+    }
+
+    if (!setNoisyMax(factorName, parentNames, arma::vec({1 - leak, leak}))) {
+        return false;
+    }
+
+    for (arma::uword i = 0; i < parentNames.size(); ++i) {
+
+        graph.getId(parentNames[i], parent);
+
+        double probability = causeProbabilities[i];
+
+        CountTable& values = *findCounts(parent, factor);
+
+        values.set(0, 0, 1);
+        values.set(1, 0, 0);
+        values.set(0, 1, 1 - probability);
+        values.set(1, 1, probability);
+    }
+
+    return true;
+
+}
+
+/**
+ * Method to compute the probability of a noisy-MAX factor taking each of
+ * its states given the states of its parents. The cumulative distribution
+ * of the factor is the product of the cumulative distributions of the
+ * leak and of every parent, so the cost grows with the number of parents
+ * times the number of states rather than exponentially with the number
+ * of parents.
+ *
+ * @param factor The handle of the factor.
+ * @param parentStates The state of each parent, in the order the parents
+ * were given to setNoisyMax.
+ * @param distribution Set to the probability of each state of the factor.
+ * @return False if the factor is not noisy-MAX, there is not one state
+ * per parent, a state is not one its parent can take, or the table of a
+ * parent does not put all probability on state 0 of the factor when the
+ * parent is in state 0.
+ */
+bool BayesianNetwork::computeNoisyMax(nodeId factor, const std::vector<arma::uword>& parentStates, arma::vec& distribution) const {
+
+    if (factor.index >= noisyMaxes.size() || noisyMaxes[factor.index].empty() ||
+        parentStates.size() != noisyMaxes[factor.index].getParents().size()) {
+        return false;
+    }
+
+    const NoisyMax& model = noisyMaxes[factor.index];
+    const arma::vec& leak = model.getLeak();
+    const arma::uword states = leak.n_elem;
+
+    std::vector<const probabilityMat*> causes(parentStates.size());
+
+    for (arma::uword i = 0; i < parentStates.size(); ++i) {
+
+        const CountTable* counts = findCounts(model.getParents()[i], factor);
+
+        if (counts == NULL || parentStates[i] >= counts->getNumCols() || counts->getNumRows() < states) {
+            return false;
+        }
+
+        causes[i] = &counts->getProbabilities();
+
+        if ((*causes[i])(0, 0) < 1 - NOISY_TOLERANCE) {
+            return false;
+        }
+
+    }
+
+    distribution.set_size(states);
+
+    double cumulative = 0;
+
+    for (arma::uword state = 0; state < states; ++state) {
+
+        cumulative += leak(state);
+        distribution(state) = cumulative;
+
+    }
+
+    for (arma::uword i = 0; i < parentStates.size(); ++i) {
+
+        const probability* column = causes[i]->colptr(parentStates[i]);
+
+        cumulative = 0;
+
+        for (arma::uword state = 0; state < states; ++state) {
+
+            cumulative += column[state];
+            distribution(state) *= cumulative;
+
+        }
+    }
+
+    for (arma::uword state = states - 1; state > 0; --state) {
+        distribution(state) -= distribution(state - 1);
+    }
+
+    return true;
+
+}
+
+arma::vec BayesianNetwork::computeNoisyMax(const std::string& factorName, const std::vector<arma::uword>& parentStates) const {
+
+    nodeId factor;
+    arma::vec distribution;
+
+    if (graph.getId(factorName, factor)) {
+        computeNoisyMax(factor, parentStates, distribution);
+    }
+
+    return distribution;
+
+}
+
+/**
+ * Method for getting the probabilities for all the states of a hidden node,
+ * given that a series of visible nodes take certain values. The thought is
+ * that this will be used when there has just been measurements of visible
+ * nodes and the relevant hidden probabilities, given those measurements,
+ * have to be established.
+ *
+ * @param hidden The name of the hidden node.
+ * @param visibleStates A mapping of visible node keys to their states. This
+ * will most likely be recently measured states. Nodes that are unknown or
+ * not connected to the hidden node have nothing recorded and are skipped.
+ * @return A matrix of probabilities where each row represents a visible node.
+ * @throws std::out_of_range If a state is not one its node can take.
+ */
+arma::mat BayesianNetwork::get(const std::string& hidden, const std::map<std::string, arma::uword>& visibleStates) {
+
+    arma::mat currentStates;
+    nodeId hiddenId, visibleId;
+
+    if (!graph.getId(hidden, hiddenId)) {
+        return currentStates;
+    }
+
+    for (auto const& it : visibleStates) {
+
+        if (!graph.getId(it.first, visibleId)) {
+            continue;
+        }
+
+        const CountTable* probabilities = findCounts(hiddenId, visibleId);
+
+        /*
+         * A factor that is in the network but not connected to the
+         * hidden one has no counts to contribute.
+         */
+        if (probabilities == NULL) {
+            continue;
+        }
+
+        if (it.second >= probabilities->getNumRows()) {
+            throw std::out_of_range("BayesianNetwork::get: state out of range");
+        }
+
+        arma::rowvec counts = probabilities->getCounts().row(it.second) / weightOf(*probabilities);
+
+        currentStates = arma::join_cols(currentStates, counts);
+
+    }
+
+    return currentStates;
+
+}
+
+/**
+ * Utility method to generate data associated with a hidden node.
+ *
+ * @param thetaHidden A list of probabilities of the hidden node taking certain
+ * values. Each probability describes the value indicated by its position in
+ * the list. Thus, the list {0.38, 0.62} would indicate that there is a 38%
+ * probability that the hidden node takes the value 0 and a 62% chance that it
+ * takes the value 1.
+ * @param samples The number of data points to generate.
+ * @return A set of generated values.
+ */
+arma::rowvec BayesianNetwork::simulateHiddenData(const std::vector<double>& thetaHidden, const int samples) {
+
+    std::discrete_distribution<> dist(thetaHidden.begin(), thetaHidden.end()); // Create a custom distribution by providing an iterator to the list.
+    std::mt19937 eng(std::time(0)); // Initiate a mersenne twister.
+
+    arma::rowvec dataHidden(samples);
+
+    for (int i = 0; i < samples; ++i) { // Generate the data points
+        dataHidden(i) = dist(eng);
+    }
+
+    return dataHidden;
+
+}
+
+arma::rowvec BayesianNetwork::simulateHiddenData(const arma::rowvec& thetaHidden, int samples) {
+
+    std::discrete_distribution<> dist(thetaHidden.begin(), thetaHidden.end()); // Create a custom distribution by providing an iterator to the list.
+    std::mt19937 eng(std::time(0)); // Initiate a mersenne twister.
+
+    arma::rowvec dataHidden(samples);
+
+    for (int i = 0; i < samples; ++i) { // Generate the data points
+        dataHidden(i) = dist(eng);
+    }
+
+    return dataHidden;
+
+}
+
+arma::rowvec BayesianNetwork::simulateHiddenData(const arma::mat& thetaHidden) {
+
+    std::mt19937 eng(std::time(0)); // Initiate a mersenne twister.
+    arma::rowvec dataHidden(thetaHidden.n_rows);
+
+    int counter = 0;
+    thetaHidden.each_row([&counter, &dataHidden, &eng] (const arma::rowvec& row) {
+
+        std::discrete_distribution<> dist(row.begin(), row.end()); // Create a custom distribution by providing an iterator to the row.
+        dataHidden(counter++) = dist(eng);
+
+    });
+
+    return dataHidden;
+
+}
+
+arma::rowvec BayesianNetwork::simulateHiddenData(const arma::fmat& thetaHidden) {
+
+    std::mt19937 eng(std::time(0)); // Initiate a mersenne twister.
+    arma::rowvec dataHidden(thetaHidden.n_rows);
+
+    int counter = 0;
+    thetaHidden.each_row([&counter, &dataHidden, &eng] (const arma::frowvec& row) {
+
+        std::discrete_distribution<> dist(row.begin(), row.end()); // Create a distribution from the set of probabilities contained in the row.
+        dataHidden(counter++) = dist(eng);
+
+    });
+
+    return dataHidden;
+
+}
+
+/**
+ * Utility method to simulate visible data based on a set of hidden data.
+ * Requires data measured from a hidden node to determine which probability
+ * distribution should be used to generate the visible data.
+ *
+ * @param hiddenNode The key required to access the hidden node.
+ * @param hiddenData The data of the hidden node.
+ * @param samples The number of data points to generate.
+ * @return A mapping of visible node keys to lists of generated data.
+ */
+std::map<std::string, arma::rowvec> BayesianNetwork::simulateVisibleData(const std::string& hiddenNode,
+                                                                         const arma::rowvec& hiddenData,
+                                                                         const int samples) {
+
+    std::map<std::string, arma::mat> weights; // Get all visible nodes that the hidden node is associated with, and their weights.
+    nodeId hidden;
+
+    if (graph.getId(hiddenNode, hidden)) {
+        graph.forEachChild(hidden, [this, &weights] (nodeId visible, tableId table) {
+            weights.insert(std::pair<std::string, arma::mat>(graph.getData(visible), edgeTables.get(table).getCounts()));
+        });
+    }
+    std::map<std::string, arma::rowvec> dataVisible;
+
+    std::random_device rd;
+    std::mt19937 eng(rd());
+
+    for (auto &&node : weights) { // For each visible node.
+
+        arma::rowvec simulatedDataPoints(samples);
+
+        for (int i = 0; i < hiddenData.size(); ++i) { // For each hidden data point.
+
+            double dataPoint = hiddenData(i);
+
+            /*
+             * The weight of each edge between the hidden and the
+             * visible nodes is a matrix of probabilities. The value
+             * of the hidden node is taken as a positional indicator
+             * of which column of the matrix to look at.
+             */
+            arma::colvec col = node.second.col(dataPoint); // Pick out the column.
+
+            std::discrete_distribution<> dist(col.begin(), col.end()); // Create a distribution from the set of probabilities contained in the column by providing an iterator.
+
+            int simulatedDataPoint = dist(eng); // Generate the value.
+            simulatedDataPoints(i) = simulatedDataPoint; // Put the generated visible value in the exact same position as the hidden value. This positional correspondence is what indicates causal or temporal correspondence.
+
+        }
+
+        dataVisible.insert(std::pair<std::string, arma::rowvec>(node.first, simulatedDataPoints)); // Insert the simulated data points under the key provided.
+
+    }
+
+    return dataVisible;
+
+}
+
+std::map<std::string, arma::rowvec> BayesianNetwork::simulateVisibleData(const std::map<std::string, arma::mat>& thetaVisible,
+                                                                          const std::string& hiddenNode,
+                                                                          const arma::rowvec& hiddenData,
+                                                                          int samples) {
+
+    std::map<std::string, arma::rowvec> dataVisible;
+
+    std::random_device rd;
+    std::mt19937 eng(rd());
+
+    for (auto &&node : thetaVisible) { // For each visible node.
+
+        arma::rowvec simulatedDataPoints(samples);
+
+        for (int i = 0; i < hiddenData.size(); ++i) { // For each hidden data point.
+
+            double dataPoint = hiddenData(i);
+
+            /*
+             * The weight of each edge between the hidden and the
+             * visible nodes is a matrix of probabilities. The value
+             * of the hidden node is taken as a positional indicator
+             * of which column of the matrix to look at.
+             */
+            arma::colvec col = node.second.col(dataPoint); // Pick out the column.
+
+            std::discrete_distribution<> dist(col.begin(), col.end()); // Create a distribution from the set of probabilities contained in the column by providing an iterator.
+
+            int simulatedDataPoint = dist(eng); // Generate the value.
+            simulatedDataPoints(i) = simulatedDataPoint; // Put the generated visible value in the exact same position as the hidden value. This positional correspondence is what indicates causal or temporal correspondence.
+
+        }
+
+        dataVisible.insert(std::pair<std::string, arma::rowvec>(node.first, simulatedDataPoints)); // Insert the simulated data points under the key provided.
+
+    }
+    return dataVisible;
+
+}
+
+/**
+ * Method to simulate visible data based on the hidden data in a dataset,
+ * as simulateVisibleData does for lists of doubles. One column is added
+ * for every child of the hidden node, or overwritten if the dataset
+ * already has one by that name. The distribution of each column of each
+ * table is set up once rather than once per observation.
+ *
+ * @param hiddenNode The name of the hidden node, which must have a
+ * column in the dataset.
+ * @param data The dataset to read the hidden states from and write the
+ * simulated visible states to.
+ * @return False if the hidden node has no column or is not in the
+ * network, a hidden state is out of range or a visible node has more
+ * states than the dataset can store.
+ */
+template <typename S>
+bool BayesianNetwork::simulateVisibleData(const std::string& hiddenNode, Dataset<S>& data) {
+
+    nodeId hidden;
+    arma::uword hiddenCol;
+
+    if (!graph.getId(hiddenNode, hidden) || !data.getColumn(hiddenNode, hiddenCol)) {
+        return false;
+    }
+
+    for (arma::uword i = 0; i < data.getNumRows(); ++i) {
+        if (data.at(i, hiddenCol) >= cardinalities[hidden.index]) {
+            return false;
+        }
+    }
+
+    std::random_device rd;
+    std::mt19937 eng(rd());
+    bool simulated = true;
+
+    graph.forEachChild(hidden, [this, &data, &eng, &simulated, hiddenCol] (nodeId visible, tableId table) {
+
+        const arma::mat& counts = edgeTables.get(table).getCounts();
+        const std::string& name = graph.getData(visible);
+        arma::uword visibleCol;
+
+        if (counts.n_rows - 1 > std::numeric_limits<S>::max()) {
+            simulated = false;
+            return;
+        }
+
+        if (!data.getColumn(name, visibleCol)) {
+            data.addColumn(name, visibleCol);
+        }
+
+        std::vector<std::discrete_distribution<>> distributions;
+
+        for (arma::uword col = 0; col < counts.n_cols; ++col) {
+            distributions.emplace_back(counts.colptr(col), counts.colptr(col) + counts.n_rows);
+        }
+
+        const S* hiddenStates = data.colptr(hiddenCol);
+        S* visibleStates = data.colptr(visibleCol);
+
+        for (arma::uword i = 0; i < data.getNumRows(); ++i) {
+            visibleStates[i] = (S) distributions[hiddenStates[i]](eng);
+        }
+
+    });
+
+    return simulated;
+
+}
+
+/**
+ * @return The number of threads used to count data points, which by
+ * default is the number of hardware threads.
+ */
+unsigned BayesianNetwork::getNumThreads() const {
+    return numThreads;
+}
+
+/**
+ * Method for setting the largest number of threads used to count data
+ * points in computeThetaVisible. Fewer are used when there is too
+ * little data for the work to be worth splitting. Results are the same
+ * whatever the number of threads.
+ */
+void BayesianNetwork::setNumThreads(unsigned threads) {
+    numThreads = std::max(1u, threads);
+}
+
+/**
+ * @return The number of ticks it takes for the weight of an observation
+ * to halve, or zero if observations are never decayed.
+ */
+double BayesianNetwork::getHalfLife() const {
+    return halfLife;
+}
+
+/**
+ * Method for making older observations count for less than newer ones,
+ * for data that changes over time. Each observation is worth half as
+ * much once a given number of ticks have passed.
+ *
+ * Rather than shrinking every count on every tick, each new observation
+ * is given a weight that doubles every half life. Probabilities only
+ * depend on the ratios between counts, so this has the same effect,
+ * and the counts are only touched when the weight grows too large and
+ * everything is scaled back down. Counts read through get are divided
+ * by the current weight, so they are always in units of an observation
+ * recorded now.
+ *
+ * Only the tables on edges are decayed. Observations over several
+ * parents, recorded against tables set up with setParents, are refused
+ * while a half life is set.
+ *
+ * @param ticks The half life, or zero to stop decaying observations.
+ * Counts recorded so far keep their weight.
+ */
+void BayesianNetwork::setHalfLife(double ticks) {
+    halfLife = std::max(0.0, ticks);
+}
+
+/**
+ * @return The number of ticks the sliding window spans, or zero if
+ * there is no window.
+ */
+arma::uword BayesianNetwork::getWindow() const {
+    return windowBuckets;
+}
+
+/**
+ * Method for only keeping the observations recorded during the last few
+ * ticks. Each table keeps one bucket of counts per tick in the window
+ * and drops the oldest when the network ticks, so recording costs the
+ * same whatever the size of the window. As with decay, observations
+ * over several parents are refused while a window is set.
+ *
+ * @param ticks The number of ticks to keep observations for, counting
+ * the current one, or zero to keep them all. Observations recorded so
+ * far count as recorded during the current tick.
+ */
+void BayesianNetwork::setWindow(arma::uword ticks) {
+
+    windowBuckets = ticks;
+
+    edgeTables.forEach([ticks] (CountTable& counts) {
+        counts.setWindow(ticks);
+    });
+
+}
+
+/**
+ * Method for moving time on by one tick, decaying observations and
+ * moving the sliding window along if either is in use.
+ */
+void BayesianNetwork::tick() {
+
+    if (windowBuckets > 0) {
+        edgeTables.forEach([] (CountTable& counts) {
+            counts.advance();
+        });
+    }
+
+    if (halfLife == 0) {
+        return;
+    }
+
+    countWeight *= std::exp2(1 / halfLife);
+
+    if (countWeight > MAXIMUM_WEIGHT) {
+
+        const double factor = 1 / countWeight;
+
+        edgeTables.forEach([factor] (CountTable& counts) {
+            counts.scale(factor);
+        });
+
+        countWeight = 1;
+
+    }
+}
+
+/**
+ * @return The number of states factors take unless told otherwise
+ * when added.
+ */
+arma::uword BayesianNetwork::getNumStates() const {
+    return numStates;
+}
+
+/**
+ * @return The number of states the factor can take, or zero if the
+ * handle does not belong to a factor of this network.
+ */
+arma::uword BayesianNetwork::getNumStates(nodeId factor) const {
+    return factor.index < cardinalities.size() ? cardinalities[factor.index] : 0;
+}
+
+arma::uword BayesianNetwork::getNumStates(const std::string& factorName) const {
+
+    nodeId id;
+    return graph.getId(factorName, id) ? cardinalities[id.index] : numStates;
+
+}
+
+/**
+ * Method to compute the probability of a hidden node taking certain values,
+ * based on a set of data.
+ *
+ * @param dataHidden The measured values that the hidden node has taken.
+ * @return The probability that the hidden node takes a certain value. The
+ * position of each probability indicates which value it describes. 0.38
+ * in position 0 would therefore indicate that there is a 38% probability
+ * that the hidden node takes the value 0.
+ */
+arma::rowvec BayesianNetwork::computeThetaHidden(const arma::rowvec& dataHidden) {
+
+    arma::rowvec histogram(numStates, arma::fill::zeros);
+
+    for (auto &&dataPoint : dataHidden) {
+        ++histogram(dataPoint);
+    }
+
+    return histogram / dataHidden.size();
+
+}
+
+/**
+ * Method to compute the probability of a hidden node taking certain values,
+ * with one probability for each of the states of that particular node.
+ *
+ * @param hiddenNode The name of the hidden node.
+ * @param dataHidden The measured values that the hidden node has taken.
+ * @return The probability that the hidden node takes a certain value.
+ */
+arma::rowvec BayesianNetwork::computeThetaHidden(const std::string& hiddenNode, const arma::rowvec& dataHidden) {
+
+    arma::rowvec histogram(getNumStates(hiddenNode), arma::fill::zeros);
+
+    for (auto &&dataPoint : dataHidden) {
+        ++histogram(dataPoint);
+    }
+
+    return histogram / dataHidden.size();
+
+}
+
+/**
+ * Method to compute the probability of a hidden node taking certain values
+ * from its column in a dataset.
+ *
+ * @param hiddenNode The name of the hidden node.
+ * @param data The dataset holding the values the hidden node has taken.
+ * @return The probability that the hidden node takes each value, or an
+ * empty vector if the dataset has no column for it or a value is out of
+ * range.
+ */
+template <typename S>
+arma::rowvec BayesianNetwork::computeThetaHidden(const std::string& hiddenNode, const Dataset<S>& data) const {
+
+    arma::uword hiddenCol;
+
+    if (!data.getColumn(hiddenNode, hiddenCol)) {
+        return arma::rowvec();
+    }
+
+    const arma::uword states = getNumStates(hiddenNode);
+    const S* column = data.colptr(hiddenCol);
+    std::vector<size_t> histogram(states, 0);
+
+    for (arma::uword i = 0; i < data.getNumRows(); ++i) {
+
+        if (column[i] >= states) {
+            return arma::rowvec();
+        }
+
+        ++histogram[column[i]];
+
+    }
+
+    arma::rowvec theta(states);
+
+    for (arma::uword state = 0; state < states; ++state) {
+        theta(state) = histogram[state] / (double) data.getNumRows();
+    }
+
+    return theta;
+
+}
+
+/**
+ * Method to compute the probabilities of a series of visible nodes taking
+ * certain values, given that a hidden node takes certain values, based on
+ * lists of gathered data. Correspondence between hidden and visible data
+ * is indicated by the values having the same position in the respective
+ * lists of gathered data. Thus, if one measurement has been made and the
+ * hidden node measured 1 when a visible node measured 2, the values would
+ * both be placed in position 0.
+ *
+ * @param dataHidden A list of values that the hidden node has taken.
+ * @param dataVisible A map of nodes with corresponding lists of values
+ * that those nodes have taken.
+ * @return The probabilities of the visible nodes taking certain values, given
+ * that the hidden node has taken certain values.
+ */
+std::map<std::string, arma::mat>
+BayesianNetwork::computeThetaVisible(const arma::rowvec& dataHidden, const std::map<std::string, arma::rowvec>& dataVisible) {
+    return computeThetaVisible(numStates, dataHidden, dataVisible);
+}
+
+/**
+ * Method to compute the probabilities of a series of visible nodes taking
+ * certain values, given that a particular hidden node takes certain values.
+ * Each resulting matrix has one row per state of the visible node and one
+ * column per state of the hidden node.
+ *
+ * @param hiddenNode The name of the hidden node.
+ * @param dataHidden A list of values that the hidden node has taken.
+ * @param dataVisible A map of nodes with corresponding lists of values
+ * that those nodes have taken.
+ * @return The probabilities of the visible nodes taking certain values, given
+ * that the hidden node has taken certain values.
+ */
+std::map<std::string, arma::mat>
+BayesianNetwork::computeThetaVisible(const std::string& hiddenNode, const arma::rowvec& dataHidden, const std::map<std::string, arma::rowvec>& dataVisible) {
+    return computeThetaVisible(getNumStates(hiddenNode), dataHidden, dataVisible);
+}
+
+std::map<std::string, arma::mat>
+BayesianNetwork::computeThetaVisible(arma::uword hiddenStates, const arma::rowvec& dataHidden, const std::map<std::string, arma::rowvec>& dataVisible) const {
+
+    std::vector<const std::pair<const std::string, arma::rowvec>*> visibleFactors;
+    std::vector<arma::uword> visibleStates;
+
+    for (auto &&visibleFactor : dataVisible) {
+        visibleFactors.push_back(&visibleFactor);
+        visibleStates.push_back(getNumStates(visibleFactor.first));
+    }
+
+    /*
+     * The data points are split into one contiguous range per thread,
+     * each counted into histograms of its own. Counts are whole numbers
+     * well within the precision of a double, so adding the histograms
+     * up gives exactly what counting in a single pass would.
+     */
+    const arma::uword samples = dataHidden.n_elem;
+    const arma::uword shards = std::max<arma::uword>(1, std::min<arma::uword>(numThreads, samples / SAMPLES_PER_THREAD));
+
+    std::vector<std::vector<arma::mat>> histograms(shards);
+    std::vector<std::exception_ptr> errors(shards);
+
+    auto count = [&] (arma::uword shard) {
+
+        try {
+
+            const arma::uword begin = samples * shard / shards;
+            const arma::uword end = samples * (shard + 1) / shards;
+
+            for (arma::uword factor = 0; factor < visibleFactors.size(); ++factor) {
+
+                const arma::rowvec& dataFactor = visibleFactors[factor]->second;
+                arma::mat histogram(visibleStates[factor], hiddenStates, arma::fill::zeros); // Initialize a matrix to hold the counts of each measured value.
+
+                /*
+                 * Create a histogram as a first step to calculate
+                 * the probabilities. The value of the hidden factor
+                 * determines which column to increment in, the visible
+                 * factor which row.
+                 */
+                for (arma::uword i = begin; i < end; ++i) {
+                    ++histogram((arma::uword) dataFactor(i), (arma::uword) dataHidden(i));
+                }
+
+                histograms[shard].push_back(std::move(histogram));
+
+            }
+
+        } catch (...) {
+            errors[shard] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> workers;
+
+    for (arma::uword shard = 1; shard < shards; ++shard) {
+        workers.emplace_back(count, shard);
+    }
+
+    count(0);
+
+    for (auto &&worker : workers) {
+        worker.join();
+    }
+
+    for (auto &&error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /*
+     * Merge the histograms pairwise, halving their number each round
+     * until the first holds the totals.
+     */
+    for (arma::uword step = 1; step < shards; step *= 2) {
+        for (arma::uword shard = 0; shard + step < shards; shard += 2 * step) {
+            for (arma::uword factor = 0; factor < visibleFactors.size(); ++factor) {
+                histograms[shard][factor] += histograms[shard + step][factor];
+            }
+        }
+    }
+
+    std::map<std::string, arma::mat> histogramByNode;
+
+    for (arma::uword factor = 0; factor < visibleFactors.size(); ++factor) {
+        histogramByNode.insert(std::pair<std::string, arma::mat>(visibleFactors[factor]->first, histograms[0][factor]));
+    }
+
+    for (auto &&item : histogramByNode) {
+
+        /*
+         * Divide each column, element-wise, with the total number
+         * of data points in the column to get the probability.
+         */
+        item.second.each_col([&dataHidden] (arma::vec& column) {
+            column /= (float) arma::accu(column);
+        });
+
+        /*
+         * Fix points where division by zero has occurred.
+         */
+        item.second.transform([] (double val) {
+            return std::isnan(val) ? double(0) : val;
+        });
+    }
+
+    return histogramByNode;
+
+}
+
+std::map<std::string, arma::mat> BayesianNetwork::computeThetaVisible(const std::string& hiddenNode) {
+
+    std::map<std::string, arma::mat> histogramByNode;
+    nodeId hidden;
+
+    if (!graph.getId(hiddenNode, hidden)) {
+        return histogramByNode;
+    }
+
+    graph.forEachChild(hidden, [this, &histogramByNode] (nodeId visible, tableId table) {
+        histogramByNode.insert(std::pair<std::string, arma::mat>(graph.getData(visible), arma::conv_to<arma::mat>::from(edgeTables.get(table).getProbabilities())));
+    });
+
+    return histogramByNode;
+
+}
+
+/**
+ * Method to compute the probabilities of every other factor in a dataset
+ * taking certain values, given that a hidden node takes certain values.
+ * Gives the same results as computeThetaVisible does for lists of
+ * doubles, counting straight from the stored states.
+ *
+ * @param hiddenNode The name of the hidden node, which must have a
+ * column in the dataset.
+ * @param data The dataset of observations.
+ * @return One matrix per visible factor, with one row per state of that
+ * factor and one column per state of the hidden node. Factors with a
+ * value out of range, as well as every factor if a hidden value is out
+ * of range, are left out.
+ */
+template <typename S>
+std::map<std::string, arma::mat> BayesianNetwork::computeThetaVisible(const std::string& hiddenNode, const Dataset<S>& data) const {
+
+    std::map<std::string, arma::mat> histogramByNode;
+    arma::uword hiddenCol;
+
+    if (!data.getColumn(hiddenNode, hiddenCol)) {
+        return histogramByNode;
+    }
+
+    const arma::uword hiddenStates = getNumStates(hiddenNode);
+    const arma::uword rows = data.getNumRows();
+    const S* hidden = data.colptr(hiddenCol);
+
+    for (arma::uword i = 0; i < rows; ++i) {
+        if (hidden[i] >= hiddenStates) {
+            return histogramByNode;
+        }
+    }
+
+    for (arma::uword col = 0; col < data.getNumCols(); ++col) {
+
+        if (col == hiddenCol) {
+            continue;
+        }
+
+        const arma::uword visibleStates = getNumStates(data.getName(col));
+        const S* visible = data.colptr(col);
+        std::vector<size_t> histogram(visibleStates * hiddenStates, 0);
+        bool inRange = true;
+
+        for (arma::uword i = 0; i < rows; ++i) {
+            inRange &= visible[i] < visibleStates;
+        }
+
+        if (!inRange) {
+            continue;
+        }
+
+        for (arma::uword i = 0; i < rows; ++i) {
+            ++histogram[visible[i] + hidden[i] * visibleStates];
+        }
+
+        arma::mat theta(visibleStates, hiddenStates);
+
+        for (arma::uword hiddenState = 0; hiddenState < hiddenStates; ++hiddenState) {
+
+            const size_t* counts = histogram.data() + hiddenState * visibleStates;
+            size_t total = 0;
+
+            for (arma::uword visibleState = 0; visibleState < visibleStates; ++visibleState) {
+                total += counts[visibleState];
+            }
+
+            for (arma::uword visibleState = 0; visibleState < visibleStates; ++visibleState) {
+                theta(visibleState, hiddenState) = total == 0 ? 0 : counts[visibleState] / (double) total;
+            }
+        }
+
+        histogramByNode.insert(std::pair<std::string, arma::mat>(data.getName(col), theta));
+
+    }
+
+    return histogramByNode;
+
+}
+
+/**
+ * Method to get the probabilities of a visible node taking certain values,
+ * given that a hidden node takes certain values, based on the observations
+ * recorded so far. Nothing is copied, and only the columns recorded in
+ * since the last call are normalized again.
+ *
+ * @param hidden The handle of the hidden node.
+ * @param visible The handle of the visible node.
+ * @return The probabilities, one column per state of the hidden node, or
+ * NULL if the nodes are not connected. Valid until the next observation
+ * is recorded between the nodes.
+ */
+const probabilityMat* BayesianNetwork::computeThetaVisible(nodeId hidden, nodeId visible) const {
+
+    const CountTable* counts = findCounts(hidden, visible);
+
+    return counts == NULL ? NULL : &counts->getProbabilities();
+
+}
+
+/**
+ * Method to get the natural logarithm of the probabilities returned by
+ * computeThetaVisible, for use with imputeHiddenNodeLog.
+ *
+ * @param hidden The handle of the hidden node.
+ * @param visible The handle of the visible node.
+ * @return The log probabilities, or NULL if the nodes are not connected.
+ */
+const probabilityMat* BayesianNetwork::computeLogThetaVisible(nodeId hidden, nodeId visible) const {
+
+    const CountTable* counts = findCounts(hidden, visible);
+
+    return counts == NULL ? NULL : &counts->getLogProbabilities();
+
+}
+
+/*
+ * Kernels shared by the double and single precision entry points below.
+ * Probabilities are read and written in the precision they are stored
+ * in, while products and sums are always accumulated in double.
+ */
+template <typename eT>
+static void imputeLinear(const arma::Row<eT>& thetaHidden, const arma::Mat<eT>& thetaVisible, arma::Row<eT>& final) {
+
+    const arma::uword states = thetaHidden.n_elem;
+
+    final.set_size(states);
+
+    /*
+     * Product of all visible probabilities in a column, taken straight
+     * from the matrix memory so that nothing is copied.
+     */
+    auto columnProduct = [&thetaVisible] (arma::uword col) {
+
+        const eT* column = thetaVisible.colptr(col);
+        double product = 1;
+
+        for (arma::uword row = 0; row < thetaVisible.n_rows; ++row) {
+            product *= column[row];
+        }
+
+        return product;
+
+    };
+
+    for (arma::uword i = 0; i < thetaVisible.n_cols; ++i) {
+
+        /*
+         * Use everything that is not the current hidden probability
+         * as a collective "not true" value but be sure to use the
+         * theta hidden associated with each non-true column.
+         */
+        double sum = 0;
+        arma::uword j = 0;
+
+        for (arma::uword col = 0; col < thetaVisible.n_cols; ++col) {
+
+            if (col == i) {
+                continue;
+            }
+
+            double correctThetaHidden = thetaHidden(((i + 1) + j) % states);
+            sum += correctThetaHidden * columnProduct(col);
+
+            ++j;
+
+        }
+
+        /*
+         * Use the current hidden probability as the sole "true value".
+         * Then repeat the process so that every hidden probability
+         * has been treated as the true value.
+         */
+        double probVis1Unnorm = thetaHidden(i) * columnProduct(i); // i will never be greater than the number of hidden states, since the columns in thetaVisible in fact represent those states.
+
+        final(i) = (eT) (probVis1Unnorm / (sum + probVis1Unnorm));
+
+    }
+}
+
+template <typename eT>
+static void imputeLogarithmic(const arma::Row<eT>& logThetaHidden, const arma::Mat<eT>& logThetaVisible, arma::Row<eT>& final) {
+
+    const arma::uword states = logThetaHidden.n_elem;
+    double maximum = -std::numeric_limits<double>::infinity();
+
+    final.set_size(states);
+
+    for (arma::uword i = 0; i < states; ++i) {
+
+        const eT* column = logThetaVisible.colptr(i);
+        double sum = logThetaHidden(i);
+
+        for (arma::uword row = 0; row < logThetaVisible.n_rows; ++row) {
+            sum += column[row];
+        }
+
+        final(i) = (eT) sum;
+        maximum = std::max(maximum, (double) final(i));
+
+    }
+
+    if (maximum == -std::numeric_limits<double>::infinity()) {
+
+        final.zeros();
+        return;
+
+    }
+
+    /*
+     * Shift by the largest value before exponentiating so that the
+     * most likely state maps to one and nothing overflows.
+     */
+    double total = 0;
+
+    for (arma::uword i = 0; i < states; ++i) {
+
+        final(i) = (eT) std::exp(final(i) - maximum);
+        total += final(i);
+
+    }
+
+    for (arma::uword i = 0; i < states; ++i) {
+        final(i) = (eT) (final(i) / total);
+    }
+}
+
+arma::rowvec BayesianNetwork::imputeHiddenNode(const arma::rowvec& thetaHidden, const arma::mat& thetaVisible) {
+
+    arma::rowvec final;
+    imputeHiddenNode(thetaHidden, thetaVisible, final);
+
+    return final;
+
+}
+
+/**
+ * Method to compute the probability of a hidden node taking each of its
+ * values, given the probabilities of the observed visible values under
+ * each hidden value.
+ *
+ * With more than two hidden states the other columns are weighed by
+ * rotated hidden probabilities rather than their own, so the result is
+ * only the exact posterior for the first state or a uniform theta
+ * hidden. imputeHiddenNodeLog computes the exact posterior throughout.
+ *
+ * @param thetaHidden The probability of the hidden node taking each value.
+ * @param thetaVisible A matrix where each row holds the probabilities of
+ * one visible node's observed value, one column per hidden value.
+ * @param final Set to the probability of each hidden value. Reusing the
+ * same vector across calls avoids allocating.
+ */
+void BayesianNetwork::imputeHiddenNode(const arma::rowvec& thetaHidden, const arma::mat& thetaVisible, arma::rowvec& final) {
+    imputeLinear(thetaHidden, thetaVisible, final);
+}
+
+/**
+ * Single precision version of imputeHiddenNode, for probabilities stored
+ * as float. Products are still accumulated in double.
+ */
+void BayesianNetwork::imputeHiddenNode(const arma::frowvec& thetaHidden, const arma::fmat& thetaVisible, arma::frowvec& final) {
+    imputeLinear(thetaHidden, thetaVisible, final);
+}
+
+/**
+ * Method to compute the probability of a hidden node taking each of its
+ * values for every observation in a dataset, given the probabilities of
+ * the visible values under each hidden value. The logarithms of the
+ * probabilities are taken once up front and every observation goes
+ * through the same kernel as imputeHiddenNodeLog, so the result is the
+ * exact posterior however many visible factors there are.
+ *
+ * @param thetaHidden The probability of the hidden node taking each value.
+ * @param thetaVisible The probabilities of each visible factor, as given
+ * by computeThetaVisible. Factors without a column in the dataset are
+ * skipped.
+ * @param data The dataset of observations.
+ * @param final Set to one row per observation, holding the probability
+ * of each hidden value, or emptied on failure.
+ * @return False if the table of a factor does not have one column per
+ * hidden value, or a value in the dataset is not one of its rows.
+ */
+template <typename S>
+bool BayesianNetwork::imputeHiddenNode(const arma::rowvec& thetaHidden, const std::map<std::string, arma::mat>& thetaVisible,
+                                       const Dataset<S>& data, arma::mat& final) {
+
+    const arma::uword states = thetaHidden.n_elem;
+
+    std::vector<std::pair<const S*, arma::mat>> visible;
+    arma::uword col;
+
+    final.reset();
+
+    for (auto const& it : thetaVisible) {
+
+        if (!data.getColumn(it.first, col)) {
+            continue;
+        }
+
+        const S* values = data.colptr(col);
+
+        if (it.second.n_cols != states) {
+            return false;
+        }
+
+        for (arma::uword i = 0; i < data.getNumRows(); ++i) {
+            if (values[i] >= it.second.n_rows) {
+                return false;
+            }
+        }
+
+        visible.emplace_back(values, arma::log(it.second));
+
+    }
+
+    const arma::rowvec logThetaHidden = arma::log(thetaHidden);
+
+    arma::mat evidence(visible.size(), states);
+    arma::rowvec imputed(states);
+
+    final.set_size(data.getNumRows(), states);
+
+    for (arma::uword i = 0; i < data.getNumRows(); ++i) {
+
+        for (arma::uword row = 0; row < visible.size(); ++row) {
+
+            const S state = visible[row].first[i];
+            const arma::mat& logTheta = visible[row].second;
+
+            for (arma::uword hiddenState = 0; hiddenState < states; ++hiddenState) {
+                evidence(row, hiddenState) = logTheta(state, hiddenState);
+            }
+        }
+
+        imputeLogarithmic(logThetaHidden, evidence, imputed);
+
+        for (arma::uword hiddenState = 0; hiddenState < states; ++hiddenState) {
+            final(i, hiddenState) = imputed(hiddenState);
+        }
+    }
+
+    return true;
+
+}
+
+arma::rowvec BayesianNetwork::imputeHiddenNodeLog(const arma::rowvec& logThetaHidden, const arma::mat& logThetaVisible) {
+
+    arma::rowvec final;
+    imputeHiddenNodeLog(logThetaHidden, logThetaVisible, final);
+
+    return final;
+
+}
+
+/**
+ * Method to compute the probability of a hidden node taking each of its
+ * values, working with log probabilities throughout. The evidence of
+ * every visible node is summed rather than multiplied, and the result
+ * normalized with log-sum-exp, so any number of visible nodes can be
+ * combined without the product underflowing to zero. The result is the
+ * posterior of each hidden value, which matches imputeHiddenNode for two
+ * hidden states but not in general beyond that.
+ *
+ * @param logThetaHidden The log probability of the hidden node taking
+ * each value.
+ * @param logThetaVisible A matrix where each row holds the log
+ * probabilities of one visible node's observed value, one column per
+ * hidden value.
+ * @param final Set to the probability of each hidden value. All zero
+ * if no hidden value is consistent with the evidence. Reusing the same
+ * vector across calls avoids allocating.
+ */
+void BayesianNetwork::imputeHiddenNodeLog(const arma::rowvec& logThetaHidden, const arma::mat& logThetaVisible, arma::rowvec& final) {
+    imputeLogarithmic(logThetaHidden, logThetaVisible, final);
+}
+
+/**
+ * Single precision version of imputeHiddenNodeLog, for log probabilities
+ * stored as float. Sums are still accumulated in double.
+ */
+void BayesianNetwork::imputeHiddenNodeLog(const arma::frowvec& logThetaHidden, const arma::fmat& logThetaVisible, arma::frowvec& final) {
+    imputeLogarithmic(logThetaHidden, logThetaVisible, final);
+}
 
+template arma::rowvec BayesianNetwork::computeThetaHidden(const std::string&, const Dataset<uint8_t>&) const;
+template arma::rowvec BayesianNetwork::computeThetaHidden(const std::string&, const Dataset<uint16_t>&) const;
+template std::map<std::string, arma::mat> BayesianNetwork::computeThetaVisible(const std::string&, const Dataset<uint8_t>&) const;
+template std::map<std::string, arma::mat> BayesianNetwork::computeThetaVisible(const std::string&, const Dataset<uint16_t>&) const;
+template bool BayesianNetwork::simulateVisibleData(const std::string&, Dataset<uint8_t>&);
+template bool BayesianNetwork::simulateVisibleData(const std::string&, Dataset<uint16_t>&);
+template bool BayesianNetwork::imputeHiddenNode(const arma::rowvec&, const std::map<std::string, arma::mat>&, const Dataset<uint8_t>&, arma::mat&);
+template bool BayesianNetwork::imputeHiddenNode(const arma::rowvec&, const std::map<std::string, arma::mat>&, const Dataset<uint16_t>&, arma::mat&);
@@ -8,7 +8,15 @@
 #include <armadillo>
 #include "../directedGraph/Graph.h"
 #include "brain/Brain.h"
+#include "cpt/ConditionalProbabilityTable.h"
+#include "cpt/CountTable.h"
+#include "cpt/NoisyMax.h"
+#include "cpt/TablePool.h"
+#include "Dataset.h"
+#include "Precision.h"
 #include <ctime>
+#include <algorithm>
+#include <thread>
 
 /**
  * Class representing a Bayesian network. Based on a
@@ -16,37 +24,113 @@
  */
 class BayesianNetwork {
 
-    Graph<std::string, arma::mat> graph;
+    template <typename> friend class QuantizedBayesianNetwork;
+    friend class ConcurrentRecorder;
+
+    Graph<std::string, tableId> graph;
+    TablePool edgeTables;
+    std::vector<ConditionalProbabilityTable> tables;
+    std::vector<NoisyMax> noisyMaxes;
+    std::vector<arma::uword> cardinalities;
     Brain brain = Brain(400);
     arma::uword numStates = 2;
+    unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+    double halfLife = 0;
+    double countWeight = 1;
+    arma::uword windowBuckets = 0;
+
+    CountTable* findCounts(nodeId, nodeId);
+    const CountTable* findCounts(nodeId, nodeId) const;
+    tableId createCounts(arma::uword, arma::uword);
+    double weightOf(const CountTable&) const;
+    bool connectCounts(nodeId, nodeId);
+    bool connectParents(nodeId, const std::vector<std::string>&, std::vector<nodeId>&);
+    std::map<std::string, arma::mat> computeThetaVisible(arma::uword, const arma::rowvec&, const std::map<std::string, arma::rowvec>&) const;
+    ConditionalProbabilityTable* findTable(nodeId, arma::uword, const std::vector<arma::uword>&);
 
 public:
     BayesianNetwork();
     BayesianNetwork(arma::uword);
 
     arma::uword getNumStates() const;
-
-    bool add(std::string);
-
-    bool record(std::string, std::string, arma::uword, arma::uword, double);
-    bool record(std::string, std::string, arma::uword, arma::uword);
-    bool erase(std::string, std::string, arma::uword, arma::uword);
-
-    arma::mat get(std::string, std::map<std::string, arma::uword>);
-
-    arma::rowvec simulateHiddenData(std::vector<double>, int);
-    arma::rowvec simulateHiddenData(arma::rowvec, int);
-    arma::rowvec simulateHiddenData(arma::mat);
-
-    std::map<std::string, arma::rowvec> simulateVisibleData(std::string, arma::rowvec, int);
-    std::map<std::string, arma::rowvec> simulateVisibleData(std::map<std::string, arma::mat>, std::string, arma::rowvec, int);
-
-    arma::rowvec computeThetaHidden(arma::rowvec dataHidden);
-
-    std::map<std::string, arma::mat> computeThetaVisible(arma::rowvec dataHidden, std::map<std::string, arma::rowvec> dataVisible);
-    std::map<std::string, arma::mat> computeThetaVisible(std::string);
-
-    arma::rowvec imputeHiddenNode(arma::rowvec, arma::mat);
+    arma::uword getNumStates(nodeId) const;
+    arma::uword getNumStates(const std::string&) const;
+
+    unsigned getNumThreads() const;
+    void setNumThreads(unsigned);
+
+    double getHalfLife() const;
+    void setHalfLife(double);
+    arma::uword getWindow() const;
+    void setWindow(arma::uword);
+    void tick();
+
+    bool add(const std::string&);
+    bool add(std::string&&);
+    bool add(const std::string&, nodeId&);
+    bool add(std::string&&, nodeId&);
+    bool add(const std::string&, arma::uword);
+    bool add(const std::string&, arma::uword, nodeId&);
+    bool getId(const std::string&, nodeId&) const;
+    bool loadStructure(const std::vector<std::string>&, const std::vector<std::pair<std::string, std::string>>&);
+
+    bool record(const std::string&, const std::string&, arma::uword, arma::uword, double);
+    bool record(nodeId, nodeId, arma::uword, arma::uword, double);
+    bool record(const std::string&, const std::string&, arma::uword, arma::uword);
+    bool record(nodeId, nodeId, arma::uword, arma::uword);
+    bool recordBatch(const std::string&, const std::string&, const arma::uword*, const arma::uword*, size_t);
+    bool recordBatch(nodeId, nodeId, const arma::uword*, const arma::uword*, size_t);
+    bool recordBatch(const std::vector<std::string>&, const arma::umat&);
+    bool recordBatch(const std::vector<nodeId>&, const arma::umat&);
+    bool erase(const std::string&, const std::string&, arma::uword, arma::uword);
+    bool erase(nodeId, nodeId, arma::uword, arma::uword);
+
+    bool tie(const std::string&, const std::string&, const std::string&, const std::string&);
+    bool tie(nodeId, nodeId, nodeId, nodeId);
+    size_t getNumTables() const;
+
+    bool setParents(const std::string&, const std::vector<std::string>&);
+    bool record(const std::string&, arma::uword, const std::vector<arma::uword>&);
+    bool record(nodeId, arma::uword, const std::vector<arma::uword>&);
+    bool erase(const std::string&, arma::uword, const std::vector<arma::uword>&);
+    bool erase(nodeId, arma::uword, const std::vector<arma::uword>&);
+    const ConditionalProbabilityTable* getTable(nodeId) const;
+    ConditionalProbabilityTable computeThetaConditional(const std::string&) const;
+
+    bool setNoisyMax(const std::string&, const std::vector<std::string>&, const arma::vec&);
+    bool setNoisyOr(const std::string&, const std::vector<std::string>&, const std::vector<double>&, double);
+    bool computeNoisyMax(nodeId, const std::vector<arma::uword>&, arma::vec&) const;
+    arma::vec computeNoisyMax(const std::string&, const std::vector<arma::uword>&) const;
+
+    arma::mat get(const std::string&, const std::map<std::string, arma::uword>&);
+
+    arma::rowvec simulateHiddenData(const std::vector<double>&, int);
+    arma::rowvec simulateHiddenData(const arma::rowvec&, int);
+    arma::rowvec simulateHiddenData(const arma::mat&);
+    arma::rowvec simulateHiddenData(const arma::fmat&);
+
+    std::map<std::string, arma::rowvec> simulateVisibleData(const std::string&, const arma::rowvec&, int);
+    std::map<std::string, arma::rowvec> simulateVisibleData(const std::map<std::string, arma::mat>&, const std::string&, const arma::rowvec&, int);
+    template <typename S> bool simulateVisibleData(const std::string&, Dataset<S>&);
+
+    arma::rowvec computeThetaHidden(const arma::rowvec& dataHidden);
+    arma::rowvec computeThetaHidden(const std::string&, const arma::rowvec&);
+    template <typename S> arma::rowvec computeThetaHidden(const std::string&, const Dataset<S>&) const;
+
+    std::map<std::string, arma::mat> computeThetaVisible(const arma::rowvec& dataHidden, const std::map<std::string, arma::rowvec>& dataVisible);
+    std::map<std::string, arma::mat> computeThetaVisible(const std::string&, const arma::rowvec&, const std::map<std::string, arma::rowvec>&);
+    std::map<std::string, arma::mat> computeThetaVisible(const std::string&);
+    template <typename S> std::map<std::string, arma::mat> computeThetaVisible(const std::string&, const Dataset<S>&) const;
+    const probabilityMat* computeThetaVisible(nodeId, nodeId) const;
+    const probabilityMat* computeLogThetaVisible(nodeId, nodeId) const;
+
+    arma::rowvec imputeHiddenNode(const arma::rowvec&, const arma::mat&);
+    void imputeHiddenNode(const arma::rowvec&, const arma::mat&, arma::rowvec&);
+    void imputeHiddenNode(const arma::frowvec&, const arma::fmat&, arma::frowvec&);
+    template <typename S> bool imputeHiddenNode(const arma::rowvec&, const std::map<std::string, arma::mat>&, const Dataset<S>&, arma::mat&);
+    arma::rowvec imputeHiddenNodeLog(const arma::rowvec&, const arma::mat&);
+    void imputeHiddenNodeLog(const arma::rowvec&, const arma::mat&, arma::rowvec&);
+    void imputeHiddenNodeLog(const arma::frowvec&, const arma::fmat&, arma::frowvec&);
 
 };
 
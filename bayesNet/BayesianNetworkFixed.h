@@ -0,0 +1,425 @@
+#ifndef GRAPH_BAYESIANNETWORKFIXED_H
+#define GRAPH_BAYESIANNETWORKFIXED_H
+
+#include <armadillo>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include "../directedGraph/Graph.h"
+
+/**
+ * Class representing a Bayesian network in which every factor takes
+ * the same, compile time number of states. Tables are fixed size
+ * matrices stored inside the graph itself, so recording and reading
+ * them never touches the heap, and every loop over states has a bound
+ * known to the compiler and can be fully unrolled. Meant for binary
+ * and ternary networks; BayesianNetwork remains the choice when the
+ * number of states is only known at run time or differs per factor.
+ *
+ * @tparam K The number of states of every factor.
+ */
+template <arma::uword K>
+class BayesianNetworkFixed {
+
+public:
+
+    typedef arma::mat::fixed<K, K> table;
+    typedef arma::rowvec::fixed<K> distribution;
+
+private:
+
+    Graph<std::string, table> graph;
+
+    static void normalize(table &values);
+
+public:
+
+    arma::uword getNumStates() const;
+
+    bool add(const std::string &factorName);
+    bool add(std::string &&factorName);
+    bool add(const std::string &factorName, nodeId &id);
+    bool add(std::string &&factorName, nodeId &id);
+    bool getId(const std::string &factorName, nodeId &id) const;
+
+    bool record(const std::string &factor1, const std::string &factor2, arma::uword factor1State, arma::uword factor2State, double factor2Probability);
+    bool record(nodeId factor1, nodeId factor2, arma::uword factor1State, arma::uword factor2State, double factor2Probability);
+    bool record(const std::string &factor1, const std::string &factor2, arma::uword factor1State, arma::uword factor2State);
+    bool record(nodeId factor1, nodeId factor2, arma::uword factor1State, arma::uword factor2State);
+    bool erase(const std::string &factor1, const std::string &factor2, arma::uword factor1State, arma::uword factor2State);
+    bool erase(nodeId factor1, nodeId factor2, arma::uword factor1State, arma::uword factor2State);
+
+    arma::mat get(const std::string &hidden, const std::map<std::string, arma::uword> &visibleStates);
+
+    distribution computeThetaHidden(const arma::rowvec &dataHidden) const;
+    std::map<std::string, table> computeThetaVisible(const arma::rowvec &dataHidden, const std::map<std::string, arma::rowvec> &dataVisible) const;
+    std::map<std::string, table> computeThetaVisible(const std::string &hiddenNode);
+
+    distribution imputeHiddenNode(const distribution &thetaHidden, const arma::mat &thetaVisible) const;
+    void imputeHiddenNode(const distribution &thetaHidden, const arma::mat &thetaVisible, distribution &final) const;
+
+};
+
+/*
+ * Divides each column by its total. Columns without any counts are
+ * left at zero.
+ */
+template <arma::uword K>
+void BayesianNetworkFixed<K>::normalize(table &values) {
+
+    for (arma::uword col = 0; col < K; ++col) {
+
+        double total = 0;
+
+        for (arma::uword row = 0; row < K; ++row) {
+            total += values.at(row, col);
+        }
+
+        for (arma::uword row = 0; row < K; ++row) {
+            values.at(row, col) = total == 0 ? 0 : values.at(row, col) / total;
+        }
+    }
+}
+
+template <arma::uword K>
+arma::uword BayesianNetworkFixed<K>::getNumStates() const {
+    return K;
+}
+
+template <arma::uword K>
+bool BayesianNetworkFixed<K>::add(const std::string &factorName) {
+    return graph.add(factorName);
+}
+
+template <arma::uword K>
+bool BayesianNetworkFixed<K>::add(std::string &&factorName) {
+    return graph.add(std::move(factorName));
+}
+
+template <arma::uword K>
+bool BayesianNetworkFixed<K>::add(const std::string &factorName, nodeId &id) {
+    return graph.add(factorName, id);
+}
+
+template <arma::uword K>
+bool BayesianNetworkFixed<K>::add(std::string &&factorName, nodeId &id) {
+    return graph.add(std::move(factorName), id);
+}
+
+template <arma::uword K>
+bool BayesianNetworkFixed<K>::getId(const std::string &factorName, nodeId &id) const {
+    return graph.getId(factorName, id);
+}
+
+template <arma::uword K>
+bool BayesianNetworkFixed<K>::record(const std::string &factor1, const std::string &factor2, arma::uword factor1State, arma::uword factor2State, double factor2Probability) {
+
+    nodeId id1, id2;
+
+    if (!graph.getId(factor1, id1) || !graph.getId(factor2, id2)) {
+        return false;
+    }
+
+    return record(id1, id2, factor1State, factor2State, factor2Probability);
+
+}
+
+/**
+ * Method for setting a single value of the table between two factors,
+ * connecting them if they are not already.
+ *
+ * @return False if a state is out of range or the connection would make
+ * the network cyclic.
+ */
+template <arma::uword K>
+bool BayesianNetworkFixed<K>::record(nodeId factor1, nodeId factor2, arma::uword factor1State, arma::uword factor2State, double factor2Probability) {
+
+    if (factor1State >= K || factor2State >= K) {
+        return false;
+    }
+
+    auto assign = [factor1State, factor2State, factor2Probability] (table &values) {
+        values.at(factor2State, factor1State) = factor2Probability;
+    };
+
+    if (graph.modifyWeight(factor1, factor2, assign)) {
+        return true;
+    }
+
+    if (!graph.connect(factor1, factor2, table(arma::fill::zeros))) {
+        return false;
+    }
+
+    return graph.modifyWeight(factor1, factor2, assign);
+
+}
+
+template <arma::uword K>
+bool BayesianNetworkFixed<K>::record(const std::string &factor1, const std::string &factor2, arma::uword factor1State, arma::uword factor2State) {
+
+    nodeId id1, id2;
+
+    if (!graph.getId(factor1, id1) || !graph.getId(factor2, id2)) {
+        return false;
+    }
+
+    return record(id1, id2, factor1State, factor2State);
+
+}
+
+/**
+ * Method for counting an observation of two factors, connecting them
+ * if they are not already.
+ *
+ * @return False if a state is out of range or the connection would make
+ * the network cyclic.
+ */
+template <arma::uword K>
+bool BayesianNetworkFixed<K>::record(nodeId factor1, nodeId factor2, arma::uword factor1State, arma::uword factor2State) {
+
+    if (factor1State >= K || factor2State >= K) {
+        return false;
+    }
+
+    auto increment = [factor1State, factor2State] (table &values) {
+        ++values.at(factor2State, factor1State);
+    };
+
+    if (graph.modifyWeight(factor1, factor2, increment)) {
+        return true;
+    }
+
+    if (!graph.connect(factor1, factor2, table(arma::fill::zeros))) {
+        return false;
+    }
+
+    return graph.modifyWeight(factor1, factor2, increment);
+
+}
+
+template <arma::uword K>
+bool BayesianNetworkFixed<K>::erase(const std::string &factor1, const std::string &factor2, arma::uword factor1State, arma::uword factor2State) {
+
+    nodeId id1, id2;
+
+    if (!graph.getId(factor1, id1) || !graph.getId(factor2, id2)) {
+        return false;
+    }
+
+    return erase(id1, id2, factor1State, factor2State);
+
+}
+
+template <arma::uword K>
+bool BayesianNetworkFixed<K>::erase(nodeId factor1, nodeId factor2, arma::uword factor1State, arma::uword factor2State) {
+
+    table* values = graph.findWeight(factor1, factor2);
+
+    if (values == NULL || factor1State >= K || factor2State >= K || values->at(factor2State, factor1State) == 0) {
+        return false;
+    }
+
+    --values->at(factor2State, factor1State);
+
+    return true;
+
+}
+
+/**
+ * Method for getting the recorded values of a series of visible nodes
+ * in given states, one row per visible node and one column per state of
+ * the hidden node, as in BayesianNetwork::get.
+ */
+template <arma::uword K>
+arma::mat BayesianNetworkFixed<K>::get(const std::string &hidden, const std::map<std::string, arma::uword> &visibleStates) {
+
+    arma::mat currentStates(visibleStates.size(), K);
+    nodeId hiddenId, visibleId;
+    arma::uword rows = 0;
+
+    if (!graph.getId(hidden, hiddenId)) {
+        return arma::mat();
+    }
+
+    for (auto const& it : visibleStates) {
+
+        if (!graph.getId(it.first, visibleId) || it.second >= K) {
+            continue;
+        }
+
+        const table* values = graph.findWeight(hiddenId, visibleId);
+
+        if (values == NULL) {
+            continue;
+        }
+
+        for (arma::uword col = 0; col < K; ++col) {
+            currentStates.at(rows, col) = values->at(it.second, col);
+        }
+
+        ++rows;
+
+    }
+
+    currentStates.resize(rows, K);
+
+    return currentStates;
+
+}
+
+/**
+ * Method to compute the probability of a hidden node taking each of its
+ * values, based on a set of data.
+ *
+ * @throws std::out_of_range If a value is not one of the K states, as
+ * the bounds checks of BayesianNetwork::computeThetaHidden would.
+ */
+template <arma::uword K>
+typename BayesianNetworkFixed<K>::distribution BayesianNetworkFixed<K>::computeThetaHidden(const arma::rowvec &dataHidden) const {
+
+    distribution histogram(arma::fill::zeros);
+
+    for (auto &&dataPoint : dataHidden) {
+
+        if (!(dataPoint >= 0 && dataPoint < K)) {
+            throw std::out_of_range("BayesianNetworkFixed::computeThetaHidden: state out of range");
+        }
+
+        ++histogram.at((arma::uword) dataPoint);
+
+    }
+
+    for (arma::uword i = 0; i < K; ++i) {
+        histogram.at(i) /= dataHidden.n_elem;
+    }
+
+    return histogram;
+
+}
+
+/**
+ * Method to compute the probabilities of a series of visible nodes taking
+ * certain values, given that a hidden node takes certain values, based on
+ * lists of gathered data. See BayesianNetwork::computeThetaVisible.
+ *
+ * @throws std::out_of_range If a value is not one of the K states or a
+ * visible list is shorter than the hidden one.
+ */
+template <arma::uword K>
+std::map<std::string, typename BayesianNetworkFixed<K>::table>
+BayesianNetworkFixed<K>::computeThetaVisible(const arma::rowvec &dataHidden, const std::map<std::string, arma::rowvec> &dataVisible) const {
+
+    std::map<std::string, table> histogramByNode;
+
+    for (auto &&visibleFactor : dataVisible) {
+
+        const arma::rowvec& dataVisible = visibleFactor.second;
+        table histogram(arma::fill::zeros);
+
+        if (dataVisible.n_elem < dataHidden.n_elem) {
+            throw std::out_of_range("BayesianNetworkFixed::computeThetaVisible: missing visible data");
+        }
+
+        for (arma::uword i = 0; i < dataHidden.n_elem; ++i) {
+
+            const double visibleState = dataVisible.at(i), hiddenState = dataHidden.at(i);
+
+            if (!(visibleState >= 0 && visibleState < K && hiddenState >= 0 && hiddenState < K)) {
+                throw std::out_of_range("BayesianNetworkFixed::computeThetaVisible: state out of range");
+            }
+
+            ++histogram.at((arma::uword) visibleState, (arma::uword) hiddenState);
+
+        }
+
+        normalize(histogram);
+
+        histogramByNode.insert(std::pair<std::string, table>(visibleFactor.first, histogram));
+
+    }
+
+    return histogramByNode;
+
+}
+
+template <arma::uword K>
+std::map<std::string, typename BayesianNetworkFixed<K>::table> BayesianNetworkFixed<K>::computeThetaVisible(const std::string &hiddenNode) {
+
+    std::map<std::string, table> histogramByNode = graph.getWeights(hiddenNode);
+
+    for (auto &&item : histogramByNode) {
+        normalize(item.second);
+    }
+
+    return histogramByNode;
+
+}
+
+template <arma::uword K>
+typename BayesianNetworkFixed<K>::distribution BayesianNetworkFixed<K>::imputeHiddenNode(const distribution &thetaHidden, const arma::mat &thetaVisible) const {
+
+    distribution final;
+    imputeHiddenNode(thetaHidden, thetaVisible, final);
+
+    return final;
+
+}
+
+/**
+ * Method to compute the probability of a hidden node taking each of its
+ * values, giving the same results as BayesianNetwork::imputeHiddenNode.
+ *
+ * @param thetaHidden The probability of the hidden node taking each value.
+ * @param thetaVisible A matrix where each row holds the probabilities of
+ * one visible node's observed value, one column per hidden value.
+ * @param final Set to the probability of each hidden value.
+ * @throws std::invalid_argument If thetaVisible does not have one column
+ * per hidden value.
+ */
+template <arma::uword K>
+void BayesianNetworkFixed<K>::imputeHiddenNode(const distribution &thetaHidden, const arma::mat &thetaVisible, distribution &final) const {
+
+    if (thetaVisible.n_cols != K) {
+        throw std::invalid_argument("BayesianNetworkFixed::imputeHiddenNode: expected one column per hidden state");
+    }
+
+    double products[K];
+
+    for (arma::uword col = 0; col < K; ++col) {
+
+        const double* column = thetaVisible.colptr(col);
+        double product = 1;
+
+        for (arma::uword row = 0; row < thetaVisible.n_rows; ++row) {
+            product *= column[row];
+        }
+
+        products[col] = product;
+
+    }
+
+    for (arma::uword i = 0; i < K; ++i) {
+
+        double sum = 0;
+        arma::uword j = 0;
+
+        for (arma::uword col = 0; col < K; ++col) {
+
+            if (col == i) {
+                continue;
+            }
+
+            sum += thetaHidden.at(((i + 1) + j) % K) * products[col];
+
+            ++j;
+
+        }
+
+        double probVis1Unnorm = thetaHidden.at(i) * products[i];
+
+        final.at(i) = probVis1Unnorm / (sum + probVis1Unnorm);
+
+    }
+}
+
+#endif //GRAPH_BAYESIANNETWORKFIXED_H
@@ -0,0 +1,246 @@
+#include "ConcurrentRecorder.h"
+#include <functional>
+#include <new>
+#include <thread>
+
+/**
+ * Indexes the edges of a network and takes a first snapshot of its
+ * tables. Every edge has to be in place before the recorder is made.
+ */
+ConcurrentRecorder::ConcurrentRecorder(BayesianNetwork& network) : network(network), epoch(0) {
+
+    std::unordered_map<uint64_t, uint32_t> index;
+    std::unordered_map<uint32_t, uint32_t> slotByTable;
+
+    for (uint32_t i = 0; i < network.graph.size(); ++i) {
+
+        nodeId parent{i};
+
+        network.graph.forEachChild(parent, [this, &network, &index, &slotByTable, parent] (nodeId child, tableId id) {
+
+            auto it = slotByTable.find(id.index);
+
+            if (it == slotByTable.end()) {
+
+                const CountTable& counts = network.edgeTables.get(id);
+
+                it = slotByTable.emplace(id.index, (uint32_t) tables.size()).first;
+                tables.push_back(table{id, counts.getNumRows(), counts.getNumCols(), numCells});
+                numCells += counts.getNumRows() * counts.getNumCols();
+
+            }
+
+            index.emplace(key(parent, child), it->second);
+
+        });
+    }
+
+    slots = std::make_shared<const std::unordered_map<uint64_t, uint32_t>>(std::move(index));
+
+    for (auto& it : counters) {
+
+        it.reset(new std::atomic<uint64_t>[numCells]);
+
+        for (size_t cell = 0; cell < numCells; ++cell) {
+            it[cell].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    size_t space = sizeof(stripe) * STRIPES + alignof(stripe);
+    void* aligned;
+
+    stripeBuffer.reset(new char[space]);
+    aligned = stripeBuffer.get();
+    stripes = (stripe*) std::align(alignof(stripe), sizeof(stripe) * STRIPES, aligned, space);
+
+    for (unsigned i = 0; i < STRIPES; ++i) {
+        new (&stripes[i]) stripe;
+        stripes[i].writers[0].store(0, std::memory_order_relaxed);
+        stripes[i].writers[1].store(0, std::memory_order_relaxed);
+    }
+
+    std::shared_ptr<Snapshot> first = std::make_shared<Snapshot>();
+
+    first->epoch = 0;
+    first->slots = slots;
+
+    for (auto const& it : tables) {
+        first->tables.push_back(std::make_shared<const probabilityMat>(network.edgeTables.get(it.id).getProbabilities()));
+    }
+
+    snapshot = first;
+
+}
+
+bool ConcurrentRecorder::record(const std::string& factor1, const std::string& factor2, arma::uword factor1State, arma::uword factor2State) {
+
+    nodeId id1, id2;
+
+    if (!network.getId(factor1, id1) || !network.getId(factor2, id2)) {
+        return false;
+    }
+
+    return record(id1, id2, factor1State, factor2State);
+
+}
+
+/**
+ * Method for counting an observation of two factors. Safe to call from
+ * any number of threads at once, and alongside publish.
+ *
+ * @return False if the factors are not connected or a state is out of
+ * range.
+ */
+bool ConcurrentRecorder::record(nodeId factor1, nodeId factor2, arma::uword factor1State, arma::uword factor2State) {
+
+    auto it = slots->find(key(factor1, factor2));
+
+    if (it == slots->end()) {
+        return false;
+    }
+
+    const table& target = tables[it->second];
+
+    if (factor2State >= target.rows || factor1State >= target.cols) {
+        return false;
+    }
+
+    std::atomic<size_t>* writers = stripes[threadStripe()].writers;
+    unsigned current;
+
+    /*
+     * Announce the write on the current epoch and check that the epoch
+     * did not move on in the meantime. If it did, publish may already
+     * have found no writers on it, so the write goes to the next one.
+     */
+    while (true) {
+
+        current = epoch.load();
+        writers[current].fetch_add(1);
+
+        if (epoch.load() == current) {
+            break;
+        }
+
+        writers[current].fetch_sub(1);
+
+    }
+
+    counters[current][target.offset + factor2State + factor1State * target.rows].fetch_add(1, std::memory_order_relaxed);
+
+    writers[current].fetch_sub(1, std::memory_order_release);
+
+    return true;
+
+}
+
+/**
+ * Method for adding every observation recorded so far to the tables of
+ * the network, where they can be read as usual, and publishing a new
+ * snapshot of their probabilities. Observations recorded while
+ * publishing are kept for the next call. May be called while other
+ * threads are recording or reading snapshots, but not while the network
+ * is being read or changed elsewhere.
+ */
+void ConcurrentRecorder::publish() {
+
+    std::lock_guard<std::mutex> lock(publishing);
+
+    unsigned previous = epoch.load();
+
+    epoch.store(1 - previous);
+
+    /*
+     * Sequentially consistent, like the switch above, so that a thread
+     * either shows up here or sees the new epoch when it checks again.
+     */
+    for (unsigned i = 0; i < STRIPES; ++i) {
+        while (stripes[i].writers[previous].load() != 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    std::atomic<uint64_t>* drained = counters[previous].get();
+    std::shared_ptr<const Snapshot> last = std::atomic_load(&snapshot);
+    std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>();
+
+    next->epoch = last->epoch + 1;
+    next->slots = slots;
+    next->tables.reserve(tables.size());
+
+    for (arma::uword i = 0; i < tables.size(); ++i) {
+
+        const table& it = tables[i];
+        CountTable& counts = network.edgeTables.get(it.id);
+        bool changed = false;
+
+        for (arma::uword col = 0; col < it.cols; ++col) {
+            for (arma::uword row = 0; row < it.rows; ++row) {
+
+                uint64_t count = drained[it.offset + row + col * it.rows].exchange(0, std::memory_order_relaxed);
+
+                if (count > 0) {
+                    counts.add(row, col, count * network.weightOf(counts));
+                    changed = true;
+                }
+            }
+        }
+
+        /*
+         * Tables nothing was recorded in since the last publish are
+         * shared with the last snapshot rather than copied again.
+         */
+        if (changed) {
+            next->tables.push_back(std::make_shared<const probabilityMat>(counts.getProbabilities()));
+        } else {
+            next->tables.push_back(last->tables[i]);
+        }
+    }
+
+    std::atomic_store(&snapshot, std::shared_ptr<const Snapshot>(std::move(next)));
+
+}
+
+/**
+ * @return The snapshot made by the latest call to publish, or by the
+ * constructor before the first. Safe to call from any number of threads
+ * at once, and alongside publish.
+ */
+std::shared_ptr<const ConcurrentRecorder::Snapshot> ConcurrentRecorder::getSnapshot() const {
+    return std::atomic_load(&snapshot);
+}
+
+/**
+ * @return The number of calls to publish the snapshot was made after.
+ */
+uint64_t ConcurrentRecorder::Snapshot::getEpoch() const {
+    return epoch;
+}
+
+/**
+ * @return The probabilities on the edge from parent to child, one column
+ * per state of the parent, or NULL if the factors are not connected.
+ */
+const probabilityMat* ConcurrentRecorder::Snapshot::getProbabilities(nodeId parent, nodeId child) const {
+
+    auto it = slots->find(key(parent, child));
+
+    return it == slots->end() ? NULL : tables[it->second].get();
+
+}
+
+uint64_t ConcurrentRecorder::key(nodeId parent, nodeId child) {
+    return ((uint64_t) parent.index << 32) | child.index;
+}
+
+/*
+ * The stripe the calling thread announces its writes on, worked out once
+ * per thread.
+ */
+unsigned ConcurrentRecorder::threadStripe() {
+
+    static thread_local unsigned index = (unsigned) (std::hash<std::thread::id>()(std::this_thread::get_id()) % STRIPES);
+
+    return index;
+
+}
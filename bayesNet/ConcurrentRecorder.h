@@ -0,0 +1,116 @@
+#ifndef GRAPH_CONCURRENTRECORDER_H
+#define GRAPH_CONCURRENTRECORDER_H
+
+#include <armadillo>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "BayesianNetwork.h"
+
+/**
+ * Class letting any number of threads record observations into the same
+ * network at once. Every cell of every table gets an atomic counter, and
+ * recording an observation is a single relaxed increment, found through
+ * an index of the edges built up front that is never written to again.
+ * No locks are taken on the way.
+ *
+ * Counts reach the network when they are published. Counters come in two
+ * sets, and recording threads write to whichever set belongs to the
+ * current epoch. Publishing moves on to the next epoch, waits for the
+ * threads still writing to the previous set to finish, and adds that set
+ * into the tables of the network. What the network holds afterwards is
+ * therefore exactly the observations recorded before the switch, never
+ * a partial view of one still in flight.
+ *
+ * Publishing then normalizes every table into a snapshot and swaps it in
+ * atomically. Threads that need to read while others publish take the
+ * current snapshot and read from it: it is never written to once made,
+ * so it holds every table as of the same publish for as long as a thread
+ * keeps hold of it, however many publishes happen in the meantime. The
+ * network itself is still written to by publish, including the caches
+ * of probabilities its const methods fill in, so reading it directly
+ * has to be kept apart from calls to publish.
+ *
+ * The structure of the network is fixed for as long as the recorder is
+ * in use: observations between factors that are not connected are
+ * rejected, and the network must not be changed except through publish.
+ * Edges tied to the same table share its counters. The stripes are laid
+ * out in a buffer of their own, aligned by hand, since C++11 new does
+ * not honour alignment beyond that of the fundamental types; the
+ * recorder itself can be allocated in any way.
+ */
+class ConcurrentRecorder {
+
+public:
+
+    /**
+     * The probabilities of every table of the network as of one publish.
+     */
+    class Snapshot {
+
+        friend class ConcurrentRecorder;
+
+        uint64_t epoch;
+        std::shared_ptr<const std::unordered_map<uint64_t, uint32_t>> slots;
+        std::vector<std::shared_ptr<const probabilityMat>> tables;
+
+    public:
+        uint64_t getEpoch() const;
+        const probabilityMat* getProbabilities(nodeId, nodeId) const;
+
+    };
+
+private:
+
+    static const unsigned STRIPES = 64;
+
+    /*
+     * Number of threads writing to each set of counters. Each stripe
+     * has a cache line of its own so that threads do not contend on a
+     * single counter.
+     */
+    struct alignas(64) stripe {
+        std::atomic<size_t> writers[2];
+    };
+
+    struct table {
+        tableId id;
+        arma::uword rows;
+        arma::uword cols;
+        size_t offset;
+    };
+
+    BayesianNetwork& network;
+
+    std::shared_ptr<const std::unordered_map<uint64_t, uint32_t>> slots;
+    std::vector<table> tables;
+    size_t numCells = 0;
+
+    std::unique_ptr<std::atomic<uint64_t>[]> counters[2];
+    std::unique_ptr<char[]> stripeBuffer;
+    stripe* stripes;
+    std::atomic<unsigned> epoch;
+    std::mutex publishing;
+
+    std::shared_ptr<const Snapshot> snapshot;
+
+    static uint64_t key(nodeId, nodeId);
+    static unsigned threadStripe();
+
+public:
+    explicit ConcurrentRecorder(BayesianNetwork&);
+
+    bool record(const std::string&, const std::string&, arma::uword, arma::uword);
+    bool record(nodeId, nodeId, arma::uword, arma::uword);
+
+    void publish();
+    std::shared_ptr<const Snapshot> getSnapshot() const;
+
+};
+
+#endif //GRAPH_CONCURRENTRECORDER_H
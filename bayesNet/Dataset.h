@@ -0,0 +1,158 @@
+#ifndef GRAPH_DATASET_H
+#define GRAPH_DATASET_H
+
+#include <armadillo>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Class holding observations of a series of factors, one column per
+ * factor and one row per observation. States are stored as small
+ * unsigned integers, with all columns in a single contiguous block and
+ * each column contiguous within it, so a dataset of binary or ternary
+ * factors takes an eighth of the memory of one double per value and
+ * the counting loops run over plain arrays.
+ *
+ * Columns are looked up by name once and then addressed by index.
+ * Pointers to a column stay valid until a column is added.
+ *
+ * @tparam S The unsigned integer type states are stored as, uint8_t or
+ * uint16_t.
+ */
+template <typename S>
+class Dataset {
+
+    arma::uword rows = 0;
+    std::vector<std::string> names;
+    std::unordered_map<std::string, arma::uword> index;
+    std::vector<S> values;
+
+public:
+
+    Dataset() = default;
+
+    /**
+     * @param rows The number of observations.
+     */
+    explicit Dataset(arma::uword rows) : rows{rows} {}
+
+    arma::uword getNumRows() const {
+        return rows;
+    }
+
+    arma::uword getNumCols() const {
+        return names.size();
+    }
+
+    const std::string& getName(arma::uword col) const {
+        return names[col];
+    }
+
+    bool getColumn(const std::string &name, arma::uword &col) const {
+
+        auto it = index.find(name);
+
+        if (it == index.end()) {
+            return false;
+        }
+
+        col = it->second;
+
+        return true;
+
+    }
+
+    /**
+     * Method for adding a column with every state set to zero.
+     *
+     * @return False if there is already a column with the name.
+     */
+    bool addColumn(const std::string &name, arma::uword &col) {
+
+        if (!index.emplace(name, names.size()).second) {
+            return false;
+        }
+
+        col = names.size();
+        names.push_back(name);
+        values.resize(values.size() + rows, 0);
+
+        return true;
+
+    }
+
+    /**
+     * Method for adding a column from a list of states held as doubles,
+     * the way they are passed around elsewhere.
+     *
+     * @return False if there is already a column with the name, the
+     * number of states does not match the number of rows or a state does
+     * not fit the storage type.
+     */
+    bool addColumn(const std::string &name, const arma::rowvec &states) {
+
+        if (states.n_elem != rows || index.count(name) > 0) {
+            return false;
+        }
+
+        for (arma::uword i = 0; i < rows; ++i) {
+            if (states(i) < 0 || states(i) > std::numeric_limits<S>::max()) {
+                return false;
+            }
+        }
+
+        arma::uword col;
+        addColumn(name, col);
+
+        S* column = colptr(col);
+
+        for (arma::uword i = 0; i < rows; ++i) {
+            column[i] = (S) states(i);
+        }
+
+        return true;
+
+    }
+
+    S* colptr(arma::uword col) {
+        return values.data() + col * rows;
+    }
+
+    const S* colptr(arma::uword col) const {
+        return values.data() + col * rows;
+    }
+
+    S at(arma::uword row, arma::uword col) const {
+        return values[row + col * rows];
+    }
+
+    /**
+     * @return A copy of a column as doubles.
+     */
+    arma::rowvec toRowvec(arma::uword col) const {
+
+        arma::rowvec states(rows);
+        const S* column = colptr(col);
+
+        for (arma::uword i = 0; i < rows; ++i) {
+            states(i) = column[i];
+        }
+
+        return states;
+
+    }
+
+    /**
+     * @return The number of bytes taken by the states.
+     */
+    size_t getMemoryUsage() const {
+        return values.size() * sizeof(S);
+    }
+
+};
+
+#endif //GRAPH_DATASET_H
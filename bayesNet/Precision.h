@@ -0,0 +1,27 @@
+#ifndef GRAPH_PRECISION_H
+#define GRAPH_PRECISION_H
+
+#include <armadillo>
+
+/*
+ * Element type of the probabilities cached by the network. Defining
+ * BAYESNET_SINGLE_PRECISION stores them as float, halving the bandwidth
+ * of every table read during inference.
+ *
+ * That is all it changes. Counts stay double and remain the primary
+ * form of every table, so per cell a table holds 8 bytes of counts and
+ * 4 bytes of probabilities, plus 4 bytes of logarithms once those are
+ * first asked for, against 16 or 24 bytes in double precision. Sums and
+ * products over probabilities, the posteriors computed per sample by
+ * Dataset and the data drawn by simulateVisibleData are kept in double
+ * either way.
+ */
+#ifdef BAYESNET_SINGLE_PRECISION
+typedef float probability;
+#else
+typedef double probability;
+#endif
+
+typedef arma::Mat<probability> probabilityMat;
+
+#endif //GRAPH_PRECISION_H
@@ -0,0 +1,322 @@
+#ifndef GRAPH_QUANTIZEDBAYESIANNETWORK_H
+#define GRAPH_QUANTIZEDBAYESIANNETWORK_H
+
+#include <armadillo>
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include "BayesianNetwork.h"
+#include "cpt/QuantizedTable.h"
+
+/**
+ * Read only copy of a trained Bayesian network with every table of
+ * probabilities quantized to 8 or 16 bit fixed point, for hosting
+ * large models in a fraction of the memory. Inference reads the
+ * quantized values directly and scales them on the fly, without ever
+ * materializing a table of doubles.
+ *
+ * Factor handles are the same as in the network the copy was made
+ * from.
+ *
+ * @tparam Q The unsigned integer type probabilities are stored as,
+ * uint8_t or uint16_t.
+ */
+template <typename Q>
+class QuantizedBayesianNetwork {
+
+    Graph<std::string, QuantizedTable<Q>> graph;
+
+public:
+
+    explicit QuantizedBayesianNetwork(const BayesianNetwork &network);
+
+    bool getId(const std::string &factorName, nodeId &id) const;
+
+    double getErrorBound() const;
+    size_t getMemoryUsage() const;
+
+    arma::mat get(const std::string &hidden, const std::map<std::string, arma::uword> &visibleStates) const;
+
+    arma::rowvec imputeHiddenNode(const arma::rowvec &thetaHidden, const std::string &hidden, const std::map<std::string, arma::uword> &visibleStates) const;
+    void imputeHiddenNode(const arma::rowvec &thetaHidden, nodeId hidden, const std::vector<std::pair<nodeId, arma::uword>> &visibleStates, arma::rowvec &final) const;
+
+    std::map<std::string, arma::rowvec> simulateVisibleData(const std::string &hiddenNode, const arma::rowvec &hiddenData, int samples) const;
+
+};
+
+/**
+ * Quantizes the probabilities the counts recorded in a network
+ * normalize to.
+ */
+template <typename Q>
+QuantizedBayesianNetwork<Q>::QuantizedBayesianNetwork(const BayesianNetwork &network) {
+
+    std::vector<std::string> factorNames;
+    std::vector<std::tuple<std::string, std::string, QuantizedTable<Q>>> edges;
+
+    factorNames.reserve(network.graph.size());
+
+    for (uint32_t i = 0; i < network.graph.size(); ++i) {
+
+        nodeId parent{i};
+
+        factorNames.push_back(network.graph.getData(parent));
+
+        network.graph.forEachChild(parent, [&network, &edges, parent] (nodeId child, tableId table) {
+            edges.emplace_back(network.graph.getData(parent), network.graph.getData(child), QuantizedTable<Q>(network.edgeTables.get(table).getProbabilities()));
+        });
+    }
+
+    graph.build(factorNames, std::move(edges));
+
+}
+
+template <typename Q>
+bool QuantizedBayesianNetwork<Q>::getId(const std::string &factorName, nodeId &id) const {
+    return graph.getId(factorName, id);
+}
+
+/**
+ * @return The largest difference between any probability in the
+ * network and the value it was quantized to, as measured by each table
+ * when it was quantized.
+ */
+template <typename Q>
+double QuantizedBayesianNetwork<Q>::getErrorBound() const {
+
+    double bound = 0;
+
+    for (uint32_t i = 0; i < graph.size(); ++i) {
+        graph.forEachChild(nodeId{i}, [&bound] (nodeId, const QuantizedTable<Q> &table) {
+            bound = std::max(bound, table.getErrorBound());
+        });
+    }
+
+    return bound;
+
+}
+
+/**
+ * @return The number of bytes taken by the quantized tables.
+ */
+template <typename Q>
+size_t QuantizedBayesianNetwork<Q>::getMemoryUsage() const {
+
+    size_t bytes = 0;
+
+    for (uint32_t i = 0; i < graph.size(); ++i) {
+        graph.forEachChild(nodeId{i}, [&bytes] (nodeId, const QuantizedTable<Q> &table) {
+            bytes += table.getMemoryUsage();
+        });
+    }
+
+    return bytes;
+
+}
+
+/**
+ * Method for getting the probabilities of a series of visible nodes
+ * taking certain values, one row per visible node and one column per
+ * state of the hidden node. Nodes not connected to the hidden node, or
+ * in a state outside their table, are skipped.
+ */
+template <typename Q>
+arma::mat QuantizedBayesianNetwork<Q>::get(const std::string &hidden, const std::map<std::string, arma::uword> &visibleStates) const {
+
+    arma::mat currentStates;
+    nodeId hiddenId, visibleId;
+
+    if (!graph.getId(hidden, hiddenId)) {
+        return currentStates;
+    }
+
+    for (auto const& it : visibleStates) {
+
+        if (!graph.getId(it.first, visibleId)) {
+            continue;
+        }
+
+        const QuantizedTable<Q>* table = graph.findWeight(hiddenId, visibleId);
+
+        if (table == NULL || it.second >= table->getNumRows()) {
+            continue;
+        }
+
+        arma::rowvec row(table->getNumCols());
+
+        for (arma::uword col = 0; col < table->getNumCols(); ++col) {
+            row(col) = table->at(it.second, col);
+        }
+
+        currentStates = arma::join_cols(currentStates, row);
+
+    }
+
+    return currentStates;
+
+}
+
+template <typename Q>
+arma::rowvec QuantizedBayesianNetwork<Q>::imputeHiddenNode(const arma::rowvec &thetaHidden, const std::string &hidden,
+                                                           const std::map<std::string, arma::uword> &visibleStates) const {
+
+    arma::rowvec final;
+    std::vector<std::pair<nodeId, arma::uword>> states;
+    nodeId hiddenId, visibleId;
+
+    if (!graph.getId(hidden, hiddenId)) {
+        return final;
+    }
+
+    for (auto const& it : visibleStates) {
+
+        if (graph.getId(it.first, visibleId)) {
+            states.emplace_back(visibleId, it.second);
+        }
+    }
+
+    imputeHiddenNode(thetaHidden, hiddenId, states, final);
+
+    return final;
+
+}
+
+/**
+ * Method to compute the probability of a hidden node taking each of its
+ * values given the observed states of a series of visible nodes, reading
+ * the quantized tables directly. Gives the same results as
+ * BayesianNetwork::imputeHiddenNode up to the quantization error.
+ *
+ * @param thetaHidden The probability of the hidden node taking each value.
+ * @param hidden The handle of the hidden node.
+ * @param visibleStates The handle and observed state of each visible
+ * node. Nodes not connected to the hidden node are skipped.
+ * @param final Set to the probability of each hidden value.
+ * @throws std::out_of_range If a visible state is outside its table or
+ * thetaHidden has more values than a table has columns.
+ */
+template <typename Q>
+void QuantizedBayesianNetwork<Q>::imputeHiddenNode(const arma::rowvec &thetaHidden, nodeId hidden,
+                                                   const std::vector<std::pair<nodeId, arma::uword>> &visibleStates,
+                                                   arma::rowvec &final) const {
+
+    const arma::uword states = thetaHidden.n_elem;
+    arma::rowvec products(states, arma::fill::ones);
+
+    for (auto const& it : visibleStates) {
+
+        const QuantizedTable<Q>* table = graph.findWeight(hidden, it.first);
+
+        if (table == NULL) {
+            continue;
+        }
+
+        if (it.second >= table->getNumRows() || states > table->getNumCols()) {
+            throw std::out_of_range("QuantizedBayesianNetwork::imputeHiddenNode: state out of range");
+        }
+
+        for (arma::uword col = 0; col < states; ++col) {
+            products(col) *= table->at(it.second, col);
+        }
+    }
+
+    final.set_size(states);
+
+    for (arma::uword i = 0; i < states; ++i) {
+
+        double sum = 0;
+        arma::uword j = 0;
+
+        for (arma::uword col = 0; col < states; ++col) {
+
+            if (col == i) {
+                continue;
+            }
+
+            sum += thetaHidden(((i + 1) + j) % states) * products(col);
+
+            ++j;
+
+        }
+
+        double probVis1Unnorm = thetaHidden(i) * products(i);
+
+        final(i) = probVis1Unnorm / (sum + probVis1Unnorm);
+
+    }
+}
+
+/**
+ * Utility method to simulate visible data based on a set of hidden data,
+ * drawing from the quantized tables. See
+ * BayesianNetwork::simulateVisibleData.
+ *
+ * @return The simulated data of every child of the hidden node, or an
+ * empty map if the hidden node is unknown, there are more hidden values
+ * than samples, or a hidden value is not a column of every table.
+ */
+template <typename Q>
+std::map<std::string, arma::rowvec> QuantizedBayesianNetwork<Q>::simulateVisibleData(const std::string &hiddenNode,
+                                                                                     const arma::rowvec &hiddenData,
+                                                                                     int samples) const {
+
+    std::map<std::string, arma::rowvec> dataVisible;
+    nodeId hidden;
+
+    if (!graph.getId(hiddenNode, hidden) || samples < 0 || hiddenData.n_elem > (arma::uword) samples) {
+        return dataVisible;
+    }
+
+    /*
+     * Every hidden value has to pick a column in every table, so they
+     * are checked against the narrowest one before anything is drawn.
+     */
+    arma::uword columns = std::numeric_limits<arma::uword>::max();
+
+    graph.forEachChild(hidden, [&columns] (nodeId, const QuantizedTable<Q> &table) {
+        columns = std::min(columns, table.getNumCols());
+    });
+
+    for (auto const& it : hiddenData) {
+        if (!(it >= 0 && it < columns)) {
+            return dataVisible;
+        }
+    }
+
+    std::random_device rd;
+    std::mt19937 eng(rd());
+
+    graph.forEachChild(hidden, [this, &dataVisible, &eng, &hiddenData, samples] (nodeId visible, const QuantizedTable<Q> &table) {
+
+        /*
+         * The scale of a column does not change the shape of its
+         * distribution, so the stored integers are used as weights
+         * as they are.
+         */
+        std::vector<std::discrete_distribution<>> distributions;
+
+        for (arma::uword col = 0; col < table.getNumCols(); ++col) {
+            distributions.emplace_back(table.colptr(col), table.colptr(col) + table.getNumRows());
+        }
+
+        arma::rowvec simulatedDataPoints(samples);
+
+        for (arma::uword i = 0; i < hiddenData.n_elem; ++i) {
+            simulatedDataPoints(i) = distributions[(arma::uword) hiddenData(i)](eng);
+        }
+
+        dataVisible.insert(std::pair<std::string, arma::rowvec>(graph.getData(visible), simulatedDataPoints));
+
+    });
+
+    return dataVisible;
+
+}
+
+#endif //GRAPH_QUANTIZEDBAYESIANNETWORK_H
@@ -1,6 +1,9 @@
 #include <armadillo>
 #include "Brain.h"
 #include "../utilities/utilities.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 using namespace std;
 using namespace arma;
@@ -15,14 +18,33 @@ void Brain::imputeHiddenNode(arma::umat * dataHidden, arma::umat * dataVisible,
     expandVertically(&colZero, dataVisible->n_rows);
     expandVertically(&colOne, dataVisible->n_rows);
 
+    /*
+     * Work with log probabilities so that the evidence of many visible
+     * nodes can be combined without the products underflowing.
+     */
     arma::mat probVis0 = colZero % *dataVisible + (1 - colZero) % (1 - *dataVisible);
-    arma::mat probVis0Unnorm = (1 - thetaHidden) * prod(probVis0, 1);
+    arma::mat logVis0Unnorm = std::log(1 - thetaHidden) + sum(arma::log(probVis0), 1);
 
     arma::mat probVis1 = colOne % *dataVisible + (1 - colOne) % (1 - *dataVisible);
-    arma::mat probVis1Unnorm = thetaHidden * prod(probVis1, 1);
+    arma::mat logVis1Unnorm = std::log(thetaHidden) + sum(arma::log(probVis1), 1);
 
-    arma::mat hidden = probVis1Unnorm / (probVis0Unnorm + probVis1Unnorm);
-    hidden.transform( [] (double val) { return (std::isnan(val) ? double(0) : val); });
+    arma::mat hidden(logVis1Unnorm.n_rows, 1);
+
+    for (arma::uword i = 0; i < hidden.n_rows; ++i) {
+
+        double maximum = std::max(logVis0Unnorm(i), logVis1Unnorm(i));
+
+        if (maximum == -std::numeric_limits<double>::infinity()) {
+
+            hidden(i) = 0;
+            continue;
+
+        }
+
+        double vis1 = std::exp(logVis1Unnorm(i) - maximum);
+        hidden(i) = vis1 / (std::exp(logVis0Unnorm(i) - maximum) + vis1);
+
+    }
 
     *dataHidden = arma::trans(hidden > arma::mat(hidden.n_rows, hidden.n_cols, arma::fill::randu));
 
@@ -0,0 +1,150 @@
+#include "ConditionalProbabilityTable.h"
+
+ConditionalProbabilityTable::ConditionalProbabilityTable() = default;
+
+/**
+ * Creates a table with all values set to zero.
+ *
+ * @param states The number of states the factor can take.
+ * @param parents The number of states each parent can take, in the
+ * order parent states will be given in.
+ */
+ConditionalProbabilityTable::ConditionalProbabilityTable(arma::uword states, const std::vector<arma::uword>& parents)
+        : numStates{states}, parentStates(parents), strides(parents.size()) {
+
+    arma::uword stride = states;
+
+    for (arma::uword i = 0; i < parents.size(); ++i) {
+
+        strides[i] = stride;
+        stride *= parents[i];
+
+    }
+
+    values = arma::vec(stride, arma::fill::zeros);
+
+}
+
+arma::uword ConditionalProbabilityTable::getNumStates() const {
+    return numStates;
+}
+
+arma::uword ConditionalProbabilityTable::getNumParents() const {
+    return parentStates.size();
+}
+
+arma::uword ConditionalProbabilityTable::getNumAssignments() const {
+    return numStates == 0 ? 0 : values.n_elem / numStates;
+}
+
+const std::vector<arma::uword>& ConditionalProbabilityTable::getParentStates() const {
+    return parentStates;
+}
+
+bool ConditionalProbabilityTable::empty() const {
+    return numStates == 0;
+}
+
+/**
+ * Method for finding where the distribution for an assignment of
+ * parent states starts in the flat buffer.
+ *
+ * @param assignment The state of each parent, one per parent.
+ * @return The position of the first value of the distribution.
+ */
+arma::uword ConditionalProbabilityTable::offset(const arma::uword* assignment) const {
+
+    arma::uword position = 0;
+
+    for (arma::uword i = 0; i < strides.size(); ++i) {
+        position += assignment[i] * strides[i];
+    }
+
+    return position;
+
+}
+
+arma::uword ConditionalProbabilityTable::offset(const std::vector<arma::uword>& assignment) const {
+    return offset(assignment.data());
+}
+
+/**
+ * Method for getting the distribution of the factor given an assignment
+ * of parent states, without copying it.
+ *
+ * @param assignment The state of each parent, one per parent.
+ * @return A pointer to the values of each of the factor's states.
+ */
+double* ConditionalProbabilityTable::row(const arma::uword* assignment) {
+    return values.memptr() + offset(assignment);
+}
+
+const double* ConditionalProbabilityTable::row(const arma::uword* assignment) const {
+    return values.memptr() + offset(assignment);
+}
+
+double& ConditionalProbabilityTable::at(arma::uword state, const std::vector<arma::uword>& assignment) {
+    return values(offset(assignment) + state);
+}
+
+double ConditionalProbabilityTable::at(arma::uword state, const std::vector<arma::uword>& assignment) const {
+    return values(offset(assignment) + state);
+}
+
+/**
+ * Method for adding to the value of a state given an assignment of
+ * parent states, such as when counting observations.
+ */
+void ConditionalProbabilityTable::record(arma::uword state, const arma::uword* assignment, double amount) {
+    row(assignment)[state] += amount;
+}
+
+/**
+ * Method for taking back a single observation.
+ *
+ * @return False if there was no observation to take back.
+ */
+bool ConditionalProbabilityTable::erase(arma::uword state, const arma::uword* assignment) {
+
+    double* distribution = row(assignment);
+
+    if (distribution[state] == 0) {
+        return false;
+    }
+
+    --distribution[state];
+
+    return true;
+
+}
+
+/**
+ * Method for turning counts into probabilities by dividing the values
+ * for each assignment of parent states by their total. Assignments
+ * that have not been observed are left at zero.
+ */
+void ConditionalProbabilityTable::normalize() {
+
+    double* distribution = values.memptr();
+
+    for (arma::uword assignment = 0; assignment < getNumAssignments(); ++assignment, distribution += numStates) {
+
+        double total = 0;
+
+        for (arma::uword state = 0; state < numStates; ++state) {
+            total += distribution[state];
+        }
+
+        if (total == 0) {
+            continue;
+        }
+
+        for (arma::uword state = 0; state < numStates; ++state) {
+            distribution[state] /= total;
+        }
+    }
+}
+
+const arma::vec& ConditionalProbabilityTable::getValues() const {
+    return values;
+}
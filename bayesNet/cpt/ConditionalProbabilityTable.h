@@ -0,0 +1,50 @@
+#ifndef GRAPH_CONDITIONALPROBABILITYTABLE_H
+#define GRAPH_CONDITIONALPROBABILITYTABLE_H
+
+#include <armadillo>
+#include <vector>
+
+/**
+ * Class representing the conditional distribution of a factor given
+ * any number of parent factors.
+ *
+ * The table is one flat buffer. The values of the factor for a given
+ * assignment of parent states lie next to each other, and assignments
+ * are laid out with the first parent varying fastest. Finding the row
+ * of an assignment is a single multiply-add over per-parent strides,
+ * and reading the whole distribution touches one contiguous run.
+ */
+class ConditionalProbabilityTable {
+
+    arma::uword numStates = 0;
+    std::vector<arma::uword> parentStates;
+    std::vector<arma::uword> strides;
+    arma::vec values;
+
+public:
+    ConditionalProbabilityTable();
+    ConditionalProbabilityTable(arma::uword, const std::vector<arma::uword>&);
+
+    arma::uword getNumStates() const;
+    arma::uword getNumParents() const;
+    arma::uword getNumAssignments() const;
+    const std::vector<arma::uword>& getParentStates() const;
+    bool empty() const;
+
+    arma::uword offset(const arma::uword*) const;
+    arma::uword offset(const std::vector<arma::uword>&) const;
+
+    double* row(const arma::uword*);
+    const double* row(const arma::uword*) const;
+    double& at(arma::uword, const std::vector<arma::uword>&);
+    double at(arma::uword, const std::vector<arma::uword>&) const;
+
+    void record(arma::uword, const arma::uword*, double);
+    bool erase(arma::uword, const arma::uword*);
+    void normalize();
+
+    const arma::vec& getValues() const;
+
+};
+
+#endif //GRAPH_CONDITIONALPROBABILITYTABLE_H
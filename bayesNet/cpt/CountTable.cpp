@@ -0,0 +1,349 @@
+#include "CountTable.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+/*
+ * Relative slack allowed when comparing a count with the weight taken
+ * back from it, so that rounding in scaled counts does not make taking
+ * back an observation fail.
+ */
+static const double TOLERANCE = 1e-9;
+
+CountTable::CountTable() = default;
+
+/**
+ * Creates a table with all counts set to zero.
+ *
+ * @param rows The number of states of the child factor.
+ * @param cols The number of states of the parent factor.
+ */
+CountTable::CountTable(arma::uword rows, arma::uword cols)
+        : counts(rows, cols, arma::fill::zeros), probabilities(rows, cols, arma::fill::zeros), dirty(cols, 0) {}
+
+arma::uword CountTable::getNumRows() const {
+    return counts.n_rows;
+}
+
+arma::uword CountTable::getNumCols() const {
+    return counts.n_cols;
+}
+
+/**
+ * @return The raw values recorded in the table.
+ */
+const arma::mat& CountTable::getCounts() const {
+    return counts;
+}
+
+double CountTable::get(arma::uword row, arma::uword col) const {
+    return counts(row, col);
+}
+
+/**
+ * Method for overwriting a single value in the table. The table is
+ * marked as assigned, which drops any window it had and keeps it out
+ * of scaling from then on.
+ */
+void CountTable::set(arma::uword row, arma::uword col, double value) {
+
+    counts(row, col) = value;
+    touch(col);
+
+    assigned = true;
+    buckets.clear();
+    bucket = 0;
+
+}
+
+/**
+ * @return True if a value has been assigned with set, in which case the
+ * table holds parameters rather than weighted counts.
+ */
+bool CountTable::isAssigned() const {
+    return assigned;
+}
+
+void CountTable::increment(arma::uword row, arma::uword col) {
+    add(row, col, 1);
+}
+
+/**
+ * Method for counting an observation with a weight other than one, as
+ * done when older observations are decayed.
+ */
+void CountTable::add(arma::uword row, arma::uword col, double weight) {
+
+    counts(row, col) += weight;
+    touch(col);
+
+    if (!buckets.empty()) {
+        buckets[bucket](row, col) += weight;
+    }
+}
+
+/**
+ * Method for counting a batch of observations at once. The counts are
+ * added straight into the table and each column written to is marked
+ * dirty, with no other work per observation.
+ *
+ * @param rows The state of the child in each observation.
+ * @param cols The state of the parent in each observation.
+ * @param n The number of observations.
+ * @param weight The weight of each observation.
+ * @return False if a state is out of range, in which case nothing is
+ * counted.
+ */
+bool CountTable::increment(const arma::uword* rows, const arma::uword* cols, size_t n, double weight) {
+
+    const arma::uword numRows = counts.n_rows;
+    const arma::uword numCols = counts.n_cols;
+
+    for (size_t i = 0; i < n; ++i) {
+        if (rows[i] >= numRows || cols[i] >= numCols) {
+            return false;
+        }
+    }
+
+    double* values = counts.memptr();
+
+    for (size_t i = 0; i < n; ++i) {
+        values[rows[i] + cols[i] * numRows] += weight;
+        dirty[cols[i]] = PROBABILITIES | LOGARITHMS;
+    }
+
+    if (!buckets.empty()) {
+
+        double* window = buckets[bucket].memptr();
+
+        for (size_t i = 0; i < n; ++i) {
+            window[rows[i] + cols[i] * numRows] += weight;
+        }
+    }
+
+    if (n > 0) {
+        stale = PROBABILITIES | LOGARITHMS;
+    }
+
+    return true;
+
+}
+
+/**
+ * @return False if the count is already zero, in which case it is
+ * left as it is.
+ */
+bool CountTable::decrement(arma::uword row, arma::uword col) {
+    return remove(row, col, 1);
+}
+
+/**
+ * Method for taking back an observation counted with a given weight.
+ * The whole weight is taken or nothing is, and counts never go below
+ * zero. With a sliding window, the weight is taken from the most recent
+ * buckets first.
+ *
+ * @return False if the count is zero or less than the weight, in which
+ * case it is left as it is.
+ */
+bool CountTable::remove(arma::uword row, arma::uword col, double weight) {
+
+    if (counts(row, col) == 0 || counts(row, col) < weight * (1 - TOLERANCE)) {
+        return false;
+    }
+
+    counts(row, col) = std::max(0.0, counts(row, col) - weight);
+    touch(col);
+
+    for (arma::uword i = 0; i < buckets.size() && weight > 0; ++i) {
+
+        double& value = buckets[(bucket + buckets.size() - i) % buckets.size()](row, col);
+        double taken = std::min(value, weight);
+
+        value -= taken;
+        weight -= taken;
+
+    }
+
+    return true;
+
+}
+
+/**
+ * Method for multiplying every count by the same factor. Probabilities
+ * do not change, so nothing is marked dirty. Assigned tables are left
+ * as they are.
+ */
+void CountTable::scale(double factor) {
+
+    if (assigned) {
+        return;
+    }
+
+    counts *= factor;
+
+    for (auto& it : buckets) {
+        it *= factor;
+    }
+}
+
+/**
+ * Method for keeping only the counts of the last few periods, each held
+ * in a bucket of its own. Counts recorded so far go into the current
+ * bucket.
+ *
+ * @param numBuckets The number of periods to keep, or zero to keep
+ * every count. Ignored for assigned tables, which keep every value.
+ */
+void CountTable::setWindow(arma::uword numBuckets) {
+
+    if (assigned) {
+        return;
+    }
+
+    buckets.assign(numBuckets, arma::mat(counts.n_rows, counts.n_cols, arma::fill::zeros));
+    bucket = 0;
+
+    if (numBuckets > 0) {
+        buckets[0] = counts;
+    }
+}
+
+/**
+ * Method for moving on to the next period, dropping the counts of the
+ * oldest one. Costs one pass over the table, whatever the number of
+ * observations.
+ */
+void CountTable::advance() {
+
+    if (buckets.empty()) {
+        return;
+    }
+
+    bucket = (bucket + 1) % buckets.size();
+
+    arma::mat& oldest = buckets[bucket];
+
+    for (arma::uword col = 0; col < counts.n_cols; ++col) {
+
+        double* target = counts.colptr(col);
+        double* source = oldest.colptr(col);
+        bool changed = false;
+
+        for (arma::uword row = 0; row < counts.n_rows; ++row) {
+
+            if (source[row] != 0) {
+                target[row] = std::max(0.0, target[row] - source[row]);
+                source[row] = 0;
+                changed = true;
+            }
+        }
+
+        if (changed) {
+            touch(col);
+        }
+    }
+}
+
+void CountTable::touch(arma::uword col) {
+
+    dirty[col] = PROBABILITIES | LOGARITHMS;
+    stale = PROBABILITIES | LOGARITHMS;
+
+}
+
+/**
+ * Method for getting the counts normalized so that each column sums to
+ * one. Columns without any counts are all zero. Only the columns that
+ * have changed since the last call are recomputed.
+ *
+ * @return The probability of each state of the child, one column per
+ * state of the parent.
+ */
+const probabilityMat& CountTable::getProbabilities() const {
+
+    refresh(PROBABILITIES);
+
+    return probabilities;
+
+}
+
+/**
+ * Method for getting the natural logarithm of each probability. States
+ * that have never been observed have a log probability of minus
+ * infinity. The logarithms are only computed once asked for, and after
+ * that kept up to date the same way as the probabilities.
+ *
+ * @return The log probability of each state of the child, one column
+ * per state of the parent.
+ */
+const probabilityMat& CountTable::getLogProbabilities() const {
+
+    if (logProbabilities.n_elem != counts.n_elem) {
+
+        logProbabilities.set_size(counts.n_rows, counts.n_cols);
+
+        for (auto& it : dirty) {
+            it |= LOGARITHMS;
+        }
+
+        stale |= LOGARITHMS;
+
+    }
+
+    refresh(LOGARITHMS);
+
+    return logProbabilities;
+
+}
+
+/*
+ * Normalizes the dirty columns of the cache or caches asked for.
+ */
+void CountTable::refresh(char caches) const {
+
+    if (!(stale & caches)) {
+        return;
+    }
+
+    for (arma::uword col = 0; col < counts.n_cols; ++col) {
+
+        char pending = dirty[col] & caches;
+
+        if (!pending) {
+            continue;
+        }
+
+        const double* source = counts.colptr(col);
+        double total = 0;
+
+        for (arma::uword row = 0; row < counts.n_rows; ++row) {
+            total += source[row];
+        }
+
+        if (pending & PROBABILITIES) {
+
+            probability* target = probabilities.colptr(col);
+
+            for (arma::uword row = 0; row < counts.n_rows; ++row) {
+                target[row] = (probability) (total == 0 ? 0 : source[row] / total);
+            }
+        }
+
+        if (pending & LOGARITHMS) {
+
+            probability* target = logProbabilities.colptr(col);
+            double logTotal = std::log(total);
+
+            for (arma::uword row = 0; row < counts.n_rows; ++row) {
+                target[row] = (probability) (total == 0 ? -std::numeric_limits<double>::infinity() : std::log(source[row]) - logTotal);
+            }
+        }
+
+        dirty[col] &= ~caches;
+
+    }
+
+    stale &= ~caches;
+
+}
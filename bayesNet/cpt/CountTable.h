@@ -0,0 +1,78 @@
+#ifndef GRAPH_COUNTTABLE_H
+#define GRAPH_COUNTTABLE_H
+
+#include <armadillo>
+#include <cstddef>
+#include <vector>
+
+#include "../Precision.h"
+
+/**
+ * Class holding the counts recorded on an edge between a parent and a
+ * child factor, along with the probabilities they normalize to. There
+ * is one row per state of the child and one column per state of the
+ * parent.
+ *
+ * Counts and probabilities are kept apart. Writing a count only marks
+ * its column as dirty, and reading the probabilities renormalizes the
+ * dirty columns and nothing else, so the cost of a read follows the
+ * number of columns written to since the last one. The logarithms of
+ * the probabilities are cached the same way, for inference that has to
+ * combine more evidence than plain products can hold, but only from the
+ * first time they are asked for. Counts are kept in double, the cached
+ * probabilities in the precision chosen at compile time.
+ *
+ * For data that changes over time, the counts can be limited to a
+ * sliding window of periods, each counted into a bucket of its own and
+ * dropped when the window moves past it.
+ *
+ * Values can also be assigned outright with set, as when a table holds
+ * parameters rather than observations. A table that has had a value
+ * assigned is marked as such and kept out of the window and of scaling,
+ * so that assigned values read back as they were written.
+ */
+class CountTable {
+
+    static const char PROBABILITIES = 1;
+    static const char LOGARITHMS = 2;
+
+    arma::mat counts;
+    mutable probabilityMat probabilities;
+    mutable probabilityMat logProbabilities;
+    mutable std::vector<char> dirty;
+    mutable char stale = 0;
+    bool assigned = false;
+
+    std::vector<arma::mat> buckets;
+    arma::uword bucket = 0;
+
+    void touch(arma::uword);
+    void refresh(char) const;
+
+public:
+    CountTable();
+    CountTable(arma::uword, arma::uword);
+
+    arma::uword getNumRows() const;
+    arma::uword getNumCols() const;
+
+    const arma::mat& getCounts() const;
+    double get(arma::uword, arma::uword) const;
+    void set(arma::uword, arma::uword, double);
+    bool isAssigned() const;
+    void increment(arma::uword, arma::uword);
+    bool increment(const arma::uword*, const arma::uword*, size_t, double = 1);
+    bool decrement(arma::uword, arma::uword);
+    void add(arma::uword, arma::uword, double);
+    bool remove(arma::uword, arma::uword, double);
+    void scale(double);
+
+    void setWindow(arma::uword);
+    void advance();
+
+    const probabilityMat& getProbabilities() const;
+    const probabilityMat& getLogProbabilities() const;
+
+};
+
+#endif //GRAPH_COUNTTABLE_H
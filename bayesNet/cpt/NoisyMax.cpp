@@ -0,0 +1,23 @@
+#include "NoisyMax.h"
+
+NoisyMax::NoisyMax() = default;
+
+/**
+ * @param parents The parents of the factor, in the order their states
+ * will be given in.
+ * @param leak The probability of the factor taking each of its states
+ * when every parent is in state 0.
+ */
+NoisyMax::NoisyMax(const std::vector<nodeId>& parents, const arma::vec& leak) : parents(parents), leak(leak) {}
+
+bool NoisyMax::empty() const {
+    return leak.n_elem == 0;
+}
+
+const std::vector<nodeId>& NoisyMax::getParents() const {
+    return parents;
+}
+
+const arma::vec& NoisyMax::getLeak() const {
+    return leak;
+}
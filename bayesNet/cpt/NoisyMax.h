@@ -0,0 +1,37 @@
+#ifndef GRAPH_NOISYMAX_H
+#define GRAPH_NOISYMAX_H
+
+#include <armadillo>
+#include <vector>
+
+#include "../../directedGraph/NodeId.h"
+
+/**
+ * Class describing a factor whose parents influence it independently
+ * of each other, following the noisy-MAX model. Each parent, depending
+ * on its state, pushes the factor up to some level, and the factor
+ * takes the highest level any parent or the leak pushes it to. Noisy-OR
+ * is the special case of a binary factor with binary parents.
+ *
+ * Only the leak and the order of the parents are kept here. How a
+ * parent in a given state pushes the factor is the table of probabilities
+ * on the edge from the parent to the factor, one column per state of
+ * the parent, so the model takes a single table per parent rather than
+ * one row per assignment of states to all the parents.
+ */
+class NoisyMax {
+
+    std::vector<nodeId> parents;
+    arma::vec leak;
+
+public:
+    NoisyMax();
+    NoisyMax(const std::vector<nodeId>&, const arma::vec&);
+
+    bool empty() const;
+    const std::vector<nodeId>& getParents() const;
+    const arma::vec& getLeak() const;
+
+};
+
+#endif //GRAPH_NOISYMAX_H
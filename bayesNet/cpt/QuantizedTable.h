@@ -0,0 +1,143 @@
+#ifndef GRAPH_QUANTIZEDTABLE_H
+#define GRAPH_QUANTIZEDTABLE_H
+
+#include <armadillo>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+/**
+ * Table of probabilities stored as fixed point integers, one scale per
+ * column. Each value is kept as the nearest multiple of its column's
+ * scale, which is chosen so that the largest probability in the column
+ * maps to the largest integer the storage type can hold, so the error
+ * of any value is about half the scale of its column.
+ *
+ * The values take an eighth of the memory of doubles with 8 bit storage
+ * and a quarter with 16 bit storage, but every column adds a float
+ * scale, which weighs the most on short columns. For tables of 8 by 8
+ * states that works out to about 5.3 times less memory than doubles
+ * with 8 bit storage and only about 3.2 times less with 16 bit storage.
+ *
+ * @tparam Q The unsigned integer type values are stored as.
+ */
+template <typename Q>
+class QuantizedTable {
+
+    arma::uword rows = 0;
+    arma::uword cols = 0;
+    std::vector<Q> values;
+    std::vector<float> scales;
+    double error = 0;
+
+public:
+
+    QuantizedTable() = default;
+
+    /**
+     * Quantizes a table of probabilities.
+     *
+     * @param probabilities One column per state of the parent factor.
+     */
+    template <typename eT>
+    explicit QuantizedTable(const arma::Mat<eT> &probabilities)
+            : rows{probabilities.n_rows}, cols{probabilities.n_cols}, values(probabilities.n_elem), scales(probabilities.n_cols) {
+
+        const double levels = std::numeric_limits<Q>::max();
+
+        for (arma::uword col = 0; col < cols; ++col) {
+
+            const eT* column = probabilities.colptr(col);
+            double maximum = 0;
+
+            for (arma::uword row = 0; row < rows; ++row) {
+                maximum = std::max(maximum, (double) column[row]);
+            }
+
+            scales[col] = (float) (maximum / levels);
+
+            for (arma::uword row = 0; row < rows; ++row) {
+
+                values[row + col * rows] = maximum == 0 ? 0 : (Q) std::min(levels, std::round((double) column[row] / scales[col]));
+                error = std::max(error, std::abs(at(row, col) - (double) column[row]));
+
+            }
+        }
+    }
+
+    arma::uword getNumRows() const {
+        return rows;
+    }
+
+    arma::uword getNumCols() const {
+        return cols;
+    }
+
+    /**
+     * @throws std::out_of_range If the row or column is outside the
+     * table.
+     */
+    double get(arma::uword row, arma::uword col) const {
+
+        if (row >= rows || col >= cols) {
+            throw std::out_of_range("QuantizedTable::get: index out of bounds");
+        }
+
+        return at(row, col);
+
+    }
+
+    /**
+     * Unchecked version of get, for loops that have already validated
+     * their bounds.
+     */
+    double at(arma::uword row, arma::uword col) const {
+        return values[row + col * rows] * (double) scales[col];
+    }
+
+    const Q* colptr(arma::uword col) const {
+        return values.data() + col * rows;
+    }
+
+    double getScale(arma::uword col) const {
+        return scales[col];
+    }
+
+    /**
+     * @return The largest difference between a value read from the
+     * table and the probability it was quantized from, measured when the
+     * table was made. Measured rather than worked out from the scales,
+     * since those are rounded to float and the half step they imply is
+     * not a strict bound.
+     */
+    double getErrorBound() const {
+        return error;
+    }
+
+    /**
+     * @return The number of bytes taken by the values and scales.
+     */
+    size_t getMemoryUsage() const {
+        return values.size() * sizeof(Q) + scales.size() * sizeof(float);
+    }
+
+    arma::mat dequantize() const {
+
+        arma::mat result(rows, cols);
+
+        for (arma::uword col = 0; col < cols; ++col) {
+            for (arma::uword row = 0; row < rows; ++row) {
+                result(row, col) = at(row, col);
+            }
+        }
+
+        return result;
+
+    }
+
+};
+
+#endif //GRAPH_QUANTIZEDTABLE_H
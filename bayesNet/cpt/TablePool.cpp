@@ -0,0 +1,67 @@
+#include "TablePool.h"
+
+/**
+ * Method for creating a table of zero counts, referred to once.
+ *
+ * @param rows The number of states of the child factor.
+ * @param cols The number of states of the parent factor.
+ */
+tableId TablePool::create(arma::uword rows, arma::uword cols) {
+
+    if (unused.empty()) {
+
+        tables.emplace_back(rows, cols);
+        references.push_back(1);
+
+        return tableId{(uint32_t) tables.size() - 1};
+
+    }
+
+    tableId id{unused.back()};
+    unused.pop_back();
+
+    tables[id.index] = CountTable(rows, cols);
+    references[id.index] = 1;
+
+    return id;
+
+}
+
+void TablePool::retain(tableId id) {
+    ++references[id.index];
+}
+
+/**
+ * Drops a reference to a table. The table is emptied once nothing
+ * refers to it any more, and its slot handed out by the next call to
+ * create.
+ */
+void TablePool::release(tableId id) {
+
+    if (--references[id.index] > 0) {
+        return;
+    }
+
+    tables[id.index] = CountTable();
+    unused.push_back(id.index);
+
+}
+
+CountTable& TablePool::get(tableId id) {
+    return tables[id.index];
+}
+
+const CountTable& TablePool::get(tableId id) const {
+    return tables[id.index];
+}
+
+uint32_t TablePool::getReferences(tableId id) const {
+    return references[id.index];
+}
+
+/**
+ * @return The number of tables referred to by at least one edge.
+ */
+size_t TablePool::size() const {
+    return tables.size() - unused.size();
+}
@@ -0,0 +1,57 @@
+#ifndef GRAPH_TABLEPOOL_H
+#define GRAPH_TABLEPOOL_H
+
+#include <armadillo>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "CountTable.h"
+
+/**
+ * Handle to a table of counts held in a TablePool.
+ */
+struct tableId {
+    uint32_t index;
+};
+
+/**
+ * Class owning the tables of counts of a network. Edges hold a handle
+ * to a table rather than the table itself, so several edges can share
+ * one table: counts recorded through any of them accumulate in the same
+ * place, and the parameters are learnt once from the data of all of
+ * them. Each table keeps a count of the edges referring to it and its
+ * slot is reused once the last one lets go.
+ */
+class TablePool {
+
+    std::vector<CountTable> tables;
+    std::vector<uint32_t> references;
+    std::vector<uint32_t> unused;
+
+public:
+
+    tableId create(arma::uword rows, arma::uword cols);
+    void retain(tableId id);
+    void release(tableId id);
+
+    CountTable& get(tableId id);
+    const CountTable& get(tableId id) const;
+    uint32_t getReferences(tableId id) const;
+
+    size_t size() const;
+
+    /**
+     * Calls visitor with every table in the pool, including the empty
+     * ones in unused slots.
+     */
+    template <typename F>
+    void forEach(F&& visitor) {
+        for (auto& it : tables) {
+            visitor(it);
+        }
+    }
+
+};
+
+#endif //GRAPH_TABLEPOOL_H
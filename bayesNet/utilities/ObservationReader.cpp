@@ -0,0 +1,373 @@
+#include "ObservationReader.h"
+#include "../BayesianNetwork.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+ObservationReader::ObservationReader() = default;
+
+ObservationReader::~ObservationReader() {
+    close();
+}
+
+/**
+ * Method for mapping a file into memory and reading the names of its
+ * columns. Any file opened before is closed first.
+ *
+ * @param path The path of the file.
+ * @param delimiter The character separating fields, ',' for CSV and
+ * '\t' for TSV.
+ * @return False if the file could not be mapped, has no header or
+ * names a column twice.
+ */
+bool ObservationReader::open(const std::string& path, char delimiter) {
+
+    close();
+
+    file = ::open(path.c_str(), O_RDONLY);
+
+    if (file < 0) {
+        return false;
+    }
+
+    struct stat status;
+
+    if (fstat(file, &status) != 0 || status.st_size == 0) {
+        close();
+        return false;
+    }
+
+    length = (size_t) status.st_size;
+
+    void* mapping = mmap(NULL, length, PROT_READ, MAP_PRIVATE, file, 0);
+
+    if (mapping == MAP_FAILED) {
+        close();
+        return false;
+    }
+
+    data = (const char*) mapping;
+    madvise(mapping, length, MADV_SEQUENTIAL);
+
+    this->delimiter = delimiter;
+
+    const char* end = data + length;
+    const char* lineEnd = endOfLine(data, end, body);
+    const char* position = data;
+
+    if (lineEnd == data) {
+        close();
+        return false;
+    }
+
+    while (true) {
+
+        const char* fieldEnd = (const char*) memchr(position, delimiter, lineEnd - position);
+
+        if (fieldEnd == NULL) {
+            fieldEnd = lineEnd;
+        }
+
+        std::string column(position, fieldEnd);
+
+        if (std::find(columns.begin(), columns.end(), column) != columns.end()) {
+            close();
+            return false;
+        }
+
+        columns.push_back(column);
+
+        if (fieldEnd == lineEnd) {
+            break;
+        }
+
+        position = fieldEnd + 1;
+
+    }
+
+    return true;
+
+}
+
+/**
+ * Unmaps the file. Dictionaries are kept.
+ */
+void ObservationReader::close() {
+
+    if (data != NULL) {
+        munmap((void*) data, length);
+    }
+
+    if (file >= 0) {
+        ::close(file);
+    }
+
+    file = -1;
+    data = NULL;
+    body = NULL;
+    length = 0;
+    columns.clear();
+
+}
+
+const std::vector<std::string>& ObservationReader::getColumns() const {
+    return columns;
+}
+
+/**
+ * Method for fixing the states the values of a column are encoded as,
+ * before any observation is read.
+ *
+ * @param column The name of the column.
+ * @param values The value for each state, in order.
+ * @return False if values of the column have already been encoded, or
+ * a value is listed twice.
+ */
+bool ObservationReader::setStates(const std::string& column, const std::vector<std::string>& values) {
+
+    dictionary& encoding = dictionaries[column];
+
+    if (!encoding.values.empty()) {
+        return false;
+    }
+
+    for (arma::uword state = 0; state < values.size(); ++state) {
+
+        if (!encoding.states.emplace(values[state], state).second) {
+            encoding = dictionary();
+            return false;
+        }
+    }
+
+    encoding.values = values;
+
+    return true;
+
+}
+
+/**
+ * @return The value of each state of a column, or NULL if nothing has
+ * been encoded for it.
+ */
+const std::vector<std::string>* ObservationReader::getStates(const std::string& column) const {
+
+    auto it = dictionaries.find(column);
+
+    return it == dictionaries.end() ? NULL : &it->second.values;
+
+}
+
+/**
+ * Method for counting every observation in the file into the network.
+ * Columns naming factors that are not in the network are skipped, and
+ * observations are recorded on the edges between the factors of the
+ * other columns, which should already be in place. Lines are parsed
+ * into a batch of states that is recorded whenever it fills up, with
+ * BayesianNetwork::recordBatch.
+ *
+ * The batch is an arma::umat, as recordBatch takes, so each state held
+ * takes 8 bytes even though few factors have more than 256 states. At
+ * the default batch size that is half a megabyte per column; a smaller
+ * batch size trades that memory for more calls to recordBatch.
+ *
+ * @param network The network to record the observations in.
+ * @param batchSize The number of observations held in memory at once.
+ * @return False if no file is open, a line has the wrong number of
+ * fields or a value is encoded as a state its factor does not have.
+ * Batches recorded before the failing one are kept, along with the rows
+ * counted and the values encoded for them; values first seen in the
+ * failing batch are dropped from the dictionaries again.
+ */
+bool ObservationReader::ingest(BayesianNetwork& network, arma::uword batchSize) {
+
+    if (data == NULL || batchSize == 0) {
+        return false;
+    }
+
+    const arma::uword skipped = columns.size();
+
+    std::vector<nodeId> factors;
+    std::vector<dictionary*> encodings;
+    std::vector<arma::uword> positions(columns.size(), skipped);
+
+    for (arma::uword col = 0; col < columns.size(); ++col) {
+
+        nodeId factor;
+
+        if (network.getId(columns[col], factor)) {
+            positions[col] = factors.size();
+            factors.push_back(factor);
+            encodings.push_back(&dictionaries[columns[col]]);
+        }
+    }
+
+    arma::umat batch(batchSize, factors.size());
+    arma::uword row = 0;
+    std::string key;
+
+    /*
+     * The size of each dictionary when the current batch was started,
+     * so that values only seen in a batch that fails can be forgotten.
+     */
+    std::vector<arma::uword> encoded(encodings.size());
+
+    auto commit = [&] () {
+
+        for (arma::uword i = 0; i < encodings.size(); ++i) {
+            encoded[i] = encodings[i]->values.size();
+        }
+    };
+
+    auto rollback = [&] () {
+
+        for (arma::uword i = 0; i < encodings.size(); ++i) {
+            truncate(*encodings[i], encoded[i]);
+        }
+
+        return false;
+
+    };
+
+    commit();
+
+    const char* end = data + length;
+    const char* position = body;
+
+    while (position < end) {
+
+        const char* next;
+        const char* lineEnd = endOfLine(position, end, next);
+
+        if (lineEnd == position) {
+            position = next;
+            continue;
+        }
+
+        arma::uword col = 0;
+
+        while (true) {
+
+            const char* fieldEnd = (const char*) memchr(position, delimiter, lineEnd - position);
+
+            if (fieldEnd == NULL) {
+                fieldEnd = lineEnd;
+            }
+
+            if (col >= columns.size()) {
+                return rollback();
+            }
+
+            if (positions[col] != skipped) {
+                batch(row, positions[col]) = encode(*encodings[positions[col]], position, fieldEnd, key);
+            }
+
+            ++col;
+
+            if (fieldEnd == lineEnd) {
+                break;
+            }
+
+            position = fieldEnd + 1;
+
+        }
+
+        if (col != columns.size()) {
+            return rollback();
+        }
+
+        position = next;
+
+        if (++row == batchSize) {
+
+            if (!network.recordBatch(factors, batch)) {
+                return rollback();
+            }
+
+            numRows += row;
+            row = 0;
+            commit();
+
+        }
+    }
+
+    batch.resize(row, factors.size());
+
+    if (!network.recordBatch(factors, batch)) {
+        return rollback();
+    }
+
+    numRows += row;
+
+    return true;
+
+}
+
+/**
+ * @return The number of observations read so far, over every file.
+ */
+size_t ObservationReader::getNumRows() const {
+    return numRows;
+}
+
+/*
+ * The end of the line starting at position, before any carriage return.
+ * Next is set to the start of the following line.
+ */
+const char* ObservationReader::endOfLine(const char* position, const char* end, const char*& next) {
+
+    const char* lineEnd = (const char*) memchr(position, '\n', end - position);
+
+    if (lineEnd == NULL) {
+        lineEnd = end;
+        next = end;
+    } else {
+        next = lineEnd + 1;
+    }
+
+    if (lineEnd > position && lineEnd[-1] == '\r') {
+        --lineEnd;
+    }
+
+    return lineEnd;
+
+}
+
+/*
+ * The state a value is encoded as, given the next free state if the
+ * value is new. The key is reused between calls to avoid allocating.
+ */
+arma::uword ObservationReader::encode(dictionary& encoding, const char* begin, const char* end, std::string& key) {
+
+    key.assign(begin, end);
+
+    auto it = encoding.states.find(key);
+
+    if (it != encoding.states.end()) {
+        return it->second;
+    }
+
+    arma::uword state = encoding.values.size();
+
+    encoding.states.emplace(key, state);
+    encoding.values.push_back(key);
+
+    return state;
+
+}
+
+/*
+ * Forgets every value encoded after the first size states.
+ */
+void ObservationReader::truncate(dictionary& encoding, arma::uword size) {
+
+    for (arma::uword state = size; state < encoding.values.size(); ++state) {
+        encoding.states.erase(encoding.values[state]);
+    }
+
+    if (size < encoding.values.size()) {
+        encoding.values.resize(size);
+    }
+}
@@ -0,0 +1,68 @@
+#ifndef GRAPH_OBSERVATIONREADER_H
+#define GRAPH_OBSERVATIONREADER_H
+
+#include <armadillo>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class BayesianNetwork;
+
+/**
+ * Class streaming observations from a delimited text file, such as CSV
+ * or TSV, straight into the tables of a network. The first line names
+ * the factor observed in each column and every following line is one
+ * observation. Values are dictionary encoded: each distinct value of a
+ * column is given the next free state of its factor, in the order the
+ * values are first seen, unless the states were set up front.
+ *
+ * The file is memory mapped and read once from start to end, and the
+ * states are counted in fixed size batches, so memory use does not grow
+ * with the size of the file. Fields are split with memchr and may not be
+ * quoted.
+ *
+ * Dictionaries are kept by column name from one file to the next, so
+ * that a series of files with the same columns is encoded the same way.
+ */
+class ObservationReader {
+
+    struct dictionary {
+        std::unordered_map<std::string, arma::uword> states;
+        std::vector<std::string> values;
+    };
+
+    int file = -1;
+    const char* data = NULL;
+    size_t length = 0;
+    const char* body = NULL;
+    char delimiter = ',';
+
+    std::vector<std::string> columns;
+    std::map<std::string, dictionary> dictionaries;
+    size_t numRows = 0;
+
+    static const char* endOfLine(const char*, const char*, const char*&);
+    static arma::uword encode(dictionary&, const char*, const char*, std::string&);
+    static void truncate(dictionary&, arma::uword);
+
+public:
+    ObservationReader();
+    ObservationReader(const ObservationReader&) = delete;
+    ObservationReader& operator=(const ObservationReader&) = delete;
+    ~ObservationReader();
+
+    bool open(const std::string&, char);
+    void close();
+
+    const std::vector<std::string>& getColumns() const;
+    bool setStates(const std::string&, const std::vector<std::string>&);
+    const std::vector<std::string>* getStates(const std::string&) const;
+
+    bool ingest(BayesianNetwork&, arma::uword = 65536);
+    size_t getNumRows() const;
+
+};
+
+#endif //GRAPH_OBSERVATIONREADER_H
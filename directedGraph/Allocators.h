@@ -0,0 +1,257 @@
+#ifndef GRAPH_ALLOCATORS_H
+#define GRAPH_ALLOCATORS_H
+
+#include <vector>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Memory resource handing out memory by bumping a pointer through
+ * large blocks. Deallocation does nothing; everything is given back
+ * at once when the arena is released or destroyed. Suited to
+ * structures that are built once and torn down as a whole.
+ */
+class MonotonicArena {
+
+    std::vector<void*> blocks;
+    char* current = NULL;
+    size_t remaining = 0;
+    size_t blockSize;
+
+public:
+
+    explicit MonotonicArena(size_t blockSize = 64 * 1024) : blockSize{blockSize} {}
+
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    ~MonotonicArena() {
+        release();
+    }
+
+    void* allocate(size_t bytes, size_t alignment) {
+
+        size_t padding = (alignment - (uintptr_t) current % alignment) % alignment;
+
+        if (current == NULL || padding + bytes > remaining) {
+
+            size_t size = bytes + alignment > blockSize ? bytes + alignment : blockSize;
+
+            current = static_cast<char*>(::operator new(size));
+            remaining = size;
+            blocks.push_back(current);
+
+            padding = (alignment - (uintptr_t) current % alignment) % alignment;
+
+        }
+
+        void* result = current + padding;
+
+        current += padding + bytes;
+        remaining -= padding + bytes;
+
+        return result;
+
+    }
+
+    void deallocate(void*, size_t) {}
+
+    /**
+     * Gives back every block at once. Anything allocated from the
+     * arena must be dead by then.
+     */
+    void release() {
+
+        for (auto const& it : blocks) {
+            ::operator delete(it);
+        }
+
+        blocks.clear();
+        current = NULL;
+        remaining = 0;
+
+    }
+
+};
+
+/**
+ * Memory resource keeping a free list per size class, so that memory
+ * given back is reused by later allocations of a similar size instead
+ * of going back to the heap. Size classes are powers of two from 16
+ * bytes up to 4 KiB; larger requests go straight to the heap. Chunks
+ * are carved out of large blocks that are only given back when the
+ * pool is released or destroyed.
+ */
+class SizeClassPool {
+
+    static const size_t MIN_SHIFT = 4;
+    static const size_t CLASSES = 9;
+
+    struct freeChunk {
+
+        freeChunk* next;
+
+    };
+
+    freeChunk* freeLists[CLASSES] = {};
+    MonotonicArena blocks;
+
+    static size_t sizeClass(size_t bytes) {
+
+        size_t index = 0;
+
+        while (((size_t) 1 << (index + MIN_SHIFT)) < bytes) {
+            ++index;
+        }
+
+        return index;
+
+    }
+
+public:
+
+    explicit SizeClassPool(size_t blockSize = 64 * 1024) : blocks(blockSize) {}
+
+    SizeClassPool(const SizeClassPool&) = delete;
+    SizeClassPool& operator=(const SizeClassPool&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment) {
+
+        size_t index = sizeClass(bytes);
+
+        if (index >= CLASSES || alignment > ((size_t) 1 << MIN_SHIFT)) {
+            return ::operator new(bytes);
+        }
+
+        freeChunk* chunk = freeLists[index];
+
+        if (chunk != NULL) {
+
+            freeLists[index] = chunk->next;
+            return chunk;
+
+        }
+
+        size_t size = (size_t) 1 << (index + MIN_SHIFT);
+
+        return blocks.allocate(size, size < 64 ? size : 64);
+
+    }
+
+    void deallocate(void* pointer, size_t bytes, size_t alignment) {
+
+        size_t index = sizeClass(bytes);
+
+        if (index >= CLASSES || alignment > ((size_t) 1 << MIN_SHIFT)) {
+
+            ::operator delete(pointer);
+            return;
+
+        }
+
+        freeChunk* chunk = static_cast<freeChunk*>(pointer);
+
+        chunk->next = freeLists[index];
+        freeLists[index] = chunk;
+
+    }
+
+    /**
+     * Gives back every block at once. Anything allocated from the
+     * pool, other than requests too large for a size class, must be
+     * dead by then.
+     */
+    void release() {
+
+        for (auto& it : freeLists) {
+            it = NULL;
+        }
+
+        blocks.release();
+
+    }
+
+};
+
+/**
+ * Standard allocator handing out memory from a MonotonicArena. Copies
+ * share the arena, which has to outlive everything allocated from it.
+ */
+template <typename V>
+class ArenaAllocator {
+
+    template <typename> friend class ArenaAllocator;
+
+    MonotonicArena* arena;
+
+public:
+
+    typedef V value_type;
+
+    explicit ArenaAllocator(MonotonicArena& arena) : arena{&arena} {}
+
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena{other.arena} {}
+
+    V* allocate(size_t n) {
+        return static_cast<V*>(arena->allocate(n * sizeof(V), alignof(V)));
+    }
+
+    void deallocate(V* pointer, size_t n) {
+        arena->deallocate(pointer, n * sizeof(V));
+    }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const {
+        return arena == other.arena;
+    }
+
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const {
+        return arena != other.arena;
+    }
+
+};
+
+/**
+ * Standard allocator handing out memory from a SizeClassPool. Copies
+ * share the pool, which has to outlive everything allocated from it.
+ */
+template <typename V>
+class PoolAllocator {
+
+    template <typename> friend class PoolAllocator;
+
+    SizeClassPool* pool;
+
+public:
+
+    typedef V value_type;
+
+    explicit PoolAllocator(SizeClassPool& pool) : pool{&pool} {}
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U>& other) : pool{other.pool} {}
+
+    V* allocate(size_t n) {
+        return static_cast<V*>(pool->allocate(n * sizeof(V), alignof(V)));
+    }
+
+    void deallocate(V* pointer, size_t n) {
+        pool->deallocate(pointer, n * sizeof(V), alignof(V));
+    }
+
+    template <typename U>
+    bool operator==(const PoolAllocator<U>& other) const {
+        return pool == other.pool;
+    }
+
+    template <typename U>
+    bool operator!=(const PoolAllocator<U>& other) const {
+        return pool != other.pool;
+    }
+
+};
+
+#endif //GRAPH_ALLOCATORS_H
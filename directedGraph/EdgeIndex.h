@@ -0,0 +1,148 @@
+#ifndef GRAPH_EDGEINDEX_H
+#define GRAPH_EDGEINDEX_H
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+/**
+ * Open addressing hash table mapping a (source, target) pair of node
+ * indices to the position of the corresponding edge in the source
+ * node's edge list. Kept next to the adjacency lists so that checking
+ * for, looking up and updating an edge does not depend on the degree
+ * of the source node. Edges are never removed from a graph, so the
+ * table only supports insertion and uses plain linear probing.
+ */
+class EdgeIndex {
+
+    static const uint32_t EMPTY = UINT32_MAX;
+
+    struct slot {
+
+        uint64_t key;
+        uint32_t value;
+
+    };
+
+    std::vector<slot> slots;
+    size_t count = 0;
+
+    static uint64_t key(uint32_t source, uint32_t target) {
+        return ((uint64_t) source << 32) | target;
+    }
+
+    /*
+     * Finalizer from MurmurHash3. Consecutive node indices are the
+     * common case, so the bits have to be mixed before masking.
+     */
+    static size_t hash(uint64_t key) {
+
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        key *= 0xc4ceb9fe1a85ec53ULL;
+        key ^= key >> 33;
+
+        return (size_t) key;
+
+    }
+
+    void rehash(size_t capacity) {
+
+        std::vector<slot> previous(capacity, slot{0, EMPTY});
+        previous.swap(slots);
+
+        for (auto const& it : previous) {
+
+            if (it.value != EMPTY) {
+                place(it.key, it.value);
+            }
+        }
+    }
+
+    void place(uint64_t k, uint32_t value) {
+
+        size_t mask = slots.size() - 1;
+        size_t i = hash(k) & mask;
+
+        while (slots[i].value != EMPTY) {
+            i = (i + 1) & mask;
+        }
+
+        slots[i].key = k;
+        slots[i].value = value;
+
+    }
+
+public:
+
+    /**
+     * Looks up the edge between two nodes.
+     *
+     * @param source The index of the node the edge starts in.
+     * @param target The index of the node the edge ends in.
+     * @param value Set to the position of the edge in the edge list
+     * of the source node, if there is one.
+     * @return Whether or not the nodes are connected.
+     */
+    bool find(uint32_t source, uint32_t target, uint32_t &value) const {
+
+        if (slots.empty()) {
+            return false;
+        }
+
+        uint64_t k = key(source, target);
+        size_t mask = slots.size() - 1;
+
+        for (size_t i = hash(k) & mask; slots[i].value != EMPTY; i = (i + 1) & mask) {
+
+            if (slots[i].key == k) {
+
+                value = slots[i].value;
+                return true;
+
+            }
+        }
+
+        return false;
+
+    }
+
+    /**
+     * Records a new edge. The edge must not already be present.
+     */
+    void insert(uint32_t source, uint32_t target, uint32_t value) {
+
+        if ((count + 1) * 2 > slots.size()) {
+            rehash(slots.empty() ? 16 : slots.size() * 2);
+        }
+
+        place(key(source, target), value);
+        ++count;
+
+    }
+
+    /**
+     * Sizes the table so that the given number of edges can be
+     * inserted without rehashing.
+     */
+    void reserve(size_t edges) {
+
+        size_t capacity = slots.empty() ? 16 : slots.size();
+
+        while (edges * 2 > capacity) {
+            capacity *= 2;
+        }
+
+        if (capacity != slots.size()) {
+            rehash(capacity);
+        }
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+};
+
+#endif //GRAPH_EDGEINDEX_H
@@ -0,0 +1,301 @@
+#ifndef GRAPH_FROZENGRAPH_H
+#define GRAPH_FROZENGRAPH_H
+
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstddef>
+
+#include "NodeId.h"
+
+/**
+ * Read only view of the nodes adjacent to a node in a frozen graph,
+ * along with the weights of the edges connecting them. For children
+ * the weights are laid out next to each other, for parents they are
+ * reached through the position of each edge in the weight pool.
+ */
+template <typename W>
+class adjacency {
+
+    const uint32_t* nodes;
+    const uint32_t* edges;
+    const W* weights;
+    size_t count;
+
+public:
+
+    adjacency(const uint32_t* nodes, const uint32_t* edges, const W* weights, size_t count)
+            : nodes{nodes}, edges{edges}, weights{weights}, count{count} {}
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    nodeId target(size_t i) const {
+        return nodeId{nodes[i]};
+    }
+
+    const W& weight(size_t i) const {
+        return edges == NULL ? weights[i] : weights[edges[i]];
+    }
+
+};
+
+/**
+ * Immutable snapshot of a graph in compressed sparse row form,
+ * produced by Graph::freeze. The children of every node are stored
+ * as one contiguous run of target indices, sorted so that single
+ * edges can be found by binary search, with the edge weights in a
+ * pool running parallel to the targets. Parents are stored the same
+ * way, pointing back into the same pool, and the topological order
+ * of the graph is kept along with them.
+ *
+ * Node handles are the same as in the graph the snapshot was taken
+ * from.
+ */
+template <class T, class W>
+class FrozenGraph {
+
+    template <class, class, class> friend class Graph;
+
+    std::vector<T> data;
+    std::unordered_map<T, uint32_t> ids;
+
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+    std::vector<W> weights;
+
+    std::vector<uint32_t> parentOffsets;
+    std::vector<uint32_t> parentNodes;
+    std::vector<uint32_t> parentEdges;
+
+    std::vector<nodeId> ordering;
+
+    void index();
+
+public:
+
+    size_t size() const;
+    bool getId(const T &key, nodeId &id) const;
+    const T& getData(nodeId id) const;
+
+    adjacency<W> children(nodeId node) const;
+    adjacency<W> parents(nodeId node) const;
+    template <typename F>
+    void forEachChild(nodeId node, F&& visitor) const;
+    template <typename F>
+    void forEachParent(nodeId node, F&& visitor) const;
+
+    const W* findWeight(nodeId node1, nodeId node2) const;
+    void getWeight(const T &node1, const T &node2, W &target) const;
+    void getWeight(nodeId node1, nodeId node2, W &target) const;
+    std::map<T, W> getWeights(const T &node) const;
+    std::map<nodeId, W> getWeights(nodeId node) const;
+    std::vector<T> topologicalSort() const;
+    void topologicalSort(std::vector<nodeId> &target) const;
+
+};
+
+/*
+ * Builds the parent arrays once the child arrays are in place.
+ */
+template <typename T, typename W>
+void FrozenGraph<T, W>::index() {
+
+    uint32_t n = (uint32_t) data.size();
+
+    parentOffsets.assign(n + 1, 0);
+    parentNodes.resize(targets.size());
+    parentEdges.resize(targets.size());
+
+    for (auto const& target : targets) {
+        ++parentOffsets[target + 1];
+    }
+
+    for (uint32_t i = 0; i < n; ++i) {
+        parentOffsets[i + 1] += parentOffsets[i];
+    }
+
+    std::vector<uint32_t> cursor(parentOffsets.begin(), parentOffsets.end() - 1);
+
+    for (uint32_t source = 0; source < n; ++source) {
+        for (uint32_t e = offsets[source]; e < offsets[source + 1]; ++e) {
+
+            uint32_t slot = cursor[targets[e]]++;
+
+            parentNodes[slot] = source;
+            parentEdges[slot] = e;
+
+        }
+    }
+}
+
+template <typename T, typename W>
+size_t FrozenGraph<T, W>::size() const {
+    return data.size();
+}
+
+template <typename T, typename W>
+bool FrozenGraph<T, W>::getId(const T &key, nodeId &id) const {
+
+    typename std::unordered_map<T, uint32_t>::const_iterator existing = ids.find(key);
+
+    if (existing == ids.end()) {
+        return false;
+    }
+
+    id.index = existing->second;
+
+    return true;
+
+}
+
+template <typename T, typename W>
+const T& FrozenGraph<T, W>::getData(nodeId id) const {
+    return data[id.index];
+}
+
+template <typename T, typename W>
+adjacency<W> FrozenGraph<T, W>::children(nodeId node) const {
+
+    uint32_t begin = offsets[node.index];
+
+    return adjacency<W>(targets.data() + begin, NULL, weights.data() + begin, offsets[node.index + 1] - begin);
+
+}
+
+template <typename T, typename W>
+adjacency<W> FrozenGraph<T, W>::parents(nodeId node) const {
+
+    uint32_t begin = parentOffsets[node.index];
+
+    return adjacency<W>(parentNodes.data() + begin, parentEdges.data() + begin, weights.data(), parentOffsets[node.index + 1] - begin);
+
+}
+
+/**
+ * Visits the children of a node, matching Graph::forEachChild so that
+ * traversals can be written once for both kinds of graph.
+ */
+template <typename T, typename W>
+template <typename F>
+void FrozenGraph<T, W>::forEachChild(nodeId node, F&& visitor) const {
+
+    for (uint32_t e = offsets[node.index]; e < offsets[node.index + 1]; ++e) {
+        visitor(nodeId{targets[e]}, weights[e]);
+    }
+}
+
+template <typename T, typename W>
+template <typename F>
+void FrozenGraph<T, W>::forEachParent(nodeId node, F&& visitor) const {
+
+    for (uint32_t p = parentOffsets[node.index]; p < parentOffsets[node.index + 1]; ++p) {
+        visitor(nodeId{parentNodes[p]}, weights[parentEdges[p]]);
+    }
+}
+
+template <typename T, typename W>
+const W* FrozenGraph<T, W>::findWeight(nodeId node1, nodeId node2) const {
+
+    if (node1.index >= data.size()) {
+        return NULL;
+    }
+
+    const uint32_t* begin = targets.data() + offsets[node1.index];
+    const uint32_t* end = targets.data() + offsets[node1.index + 1];
+    const uint32_t* it = std::lower_bound(begin, end, node2.index);
+
+    if (it == end || *it != node2.index) {
+        return NULL;
+    }
+
+    return &weights[it - targets.data()];
+
+}
+
+template <typename T, typename W>
+void FrozenGraph<T, W>::getWeight(const T &node1, const T &node2, W &target) const {
+
+    nodeId id1, id2;
+
+    if (getId(node1, id1) && getId(node2, id2)) {
+        getWeight(id1, id2, target);
+    }
+}
+
+template <typename T, typename W>
+void FrozenGraph<T, W>::getWeight(nodeId node1, nodeId node2, W &target) const {
+
+    const W* weight = findWeight(node1, node2);
+
+    if (weight != NULL) {
+        target = *weight;
+    }
+}
+
+template <typename T, typename W>
+std::map<T, W> FrozenGraph<T, W>::getWeights(const T &node) const {
+
+    std::map<T, W> result;
+    nodeId id;
+
+    if (!getId(node, id)) {
+        return result;
+    }
+
+    adjacency<W> adjacent = children(id);
+
+    for (size_t i = 0; i < adjacent.size(); ++i) {
+        result.insert(std::pair<T, W>(data[adjacent.target(i).index], adjacent.weight(i)));
+    }
+
+    return result;
+
+}
+
+template <typename T, typename W>
+std::map<nodeId, W> FrozenGraph<T, W>::getWeights(nodeId node) const {
+
+    std::map<nodeId, W> result;
+
+    if (node.index >= data.size()) {
+        return result;
+    }
+
+    adjacency<W> adjacent = children(node);
+
+    for (size_t i = 0; i < adjacent.size(); ++i) {
+        result.insert(std::pair<nodeId, W>(adjacent.target(i), adjacent.weight(i)));
+    }
+
+    return result;
+
+}
+
+template <typename T, typename W>
+std::vector<T> FrozenGraph<T, W>::topologicalSort() const {
+
+    std::vector<T> topologicalOrdering;
+    topologicalOrdering.reserve(ordering.size());
+
+    for (auto const& id : ordering) {
+        topologicalOrdering.push_back(data[id.index]);
+    }
+
+    return topologicalOrdering;
+
+}
+
+template <typename T, typename W>
+void FrozenGraph<T, W>::topologicalSort(std::vector<nodeId> &target) const {
+    target = ordering;
+}
+
+#endif //GRAPH_FROZENGRAPH_H
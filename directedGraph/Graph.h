@@ -6,232 +6,1218 @@
 #define GRAPH_GRAPH_H
 
 #include <map>
+#include <unordered_map>
 #include <vector>
 #include <queue>
 #include <algorithm>
 #include <memory>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+#include "NodeId.h"
+#include "EdgeIndex.h"
+#include "FrozenGraph.h"
+#include "Allocators.h"
 
 template <typename T, typename W>
 struct edge;
 
-template <typename T, typename W>
+template <typename T, typename W, typename A = std::allocator<W>>
 struct node;
 
 template <typename T, typename W>
 struct edge {
 
-    node<T, W>* target;
+    uint32_t target;
     W weight;
 
 };
 
-template <typename T, typename W>
+/**
+ * Link from a node back to one of its parents, locating the edge
+ * by its position in the parent's edge list so that the weight can
+ * be reached without searching.
+ */
+struct inEdge {
+
+    uint32_t source;
+    uint32_t position;
+
+};
+
+/**
+ * Node of a graph. The edge and parent lists take their memory from
+ * the allocator of the graph the node belongs to.
+ */
+template <typename T, typename W, typename A>
 struct node {
 
+    typedef std::vector<edge<T, W>, typename std::allocator_traits<A>::template rebind_alloc<edge<T, W>>> edgeList;
+    typedef std::vector<inEdge, typename std::allocator_traits<A>::template rebind_alloc<inEdge>> inEdgeList;
+
     T data;
-    int indegree = 0;
 
-    std::vector<edge<T, W>> edges;
+    edgeList edges;
+    inEdgeList parents;
+
+    node(const T &data, const A &allocator) : data(data), edges(allocator), parents(allocator) {}
+    node(T &&data, const A &allocator) : data(std::move(data)), edges(allocator), parents(allocator) {}
 
 };
 
-template <class T, class W>
+/**
+ * Directed graph with data on the nodes and weights on the edges.
+ *
+ * Nodes, their edge lists and the weights stored inline in the edges
+ * take their memory from an allocator of type A, rebound as needed.
+ * With an ArenaAllocator or PoolAllocator from Allocators.h a graph
+ * can be built without going to the heap per node and edge, and torn
+ * down by releasing the arena or pool. Memory a weight allocates for
+ * itself, like the elements of an arma::mat, is not covered.
+ */
+template <class T, class W, class A = std::allocator<W>>
 class Graph {
 
-    std::map<T, node<T, W>> nodes;
-    bool areConnected(node<T, W> first, node<T, W> second);
-    typename std::vector<edge<T, W>>::iterator getConnection(node<T, W> first, node<T, W> second);
+    typedef node<T, W, A> nodeType;
+    typedef typename nodeType::edgeList edgeList;
+    typedef typename std::allocator_traits<A>::template rebind_alloc<nodeType> nodeAllocator;
+    typedef typename std::allocator_traits<A>::template rebind_alloc<std::pair<const T, uint32_t>> idAllocator;
+
+    A allocator;
+    std::vector<nodeType, nodeAllocator> nodes;
+    std::unordered_map<T, uint32_t, std::hash<T>, std::equal_to<T>, idAllocator> ids;
+    EdgeIndex edgeIndex;
+
+    /*
+     * Topological order, kept up to date by connect. Positions map
+     * node indices to their place in the ordering.
+     */
+    std::vector<nodeId> ordering;
+    std::vector<uint32_t> positions;
+    bool ordered = true;
+
+    std::vector<uint32_t> forward, backward, stack, slots;
+    std::vector<char> visited;
+
+    bool areConnected(uint32_t first, uint32_t second);
+    typename edgeList::iterator getConnection(uint32_t first, uint32_t second);
+    bool reorder(uint32_t source, uint32_t target);
+    void insertEdge(uint32_t source, uint32_t target, W weight);
+    template <typename D>
+    bool intern(D &&data, nodeId &id);
+    template <typename V>
+    bool connectEdge(nodeId node1, nodeId node2, V &&weight);
+    template <typename V>
+    bool connectEdgeUnchecked(nodeId node1, nodeId node2, V &&weight);
+    void computeOrdering(std::vector<nodeId> &target) const;
+    bool computeOrdering(const std::vector<std::pair<uint32_t, uint32_t>> &added, std::vector<nodeId> &target) const;
+    void newEdges(std::vector<std::pair<uint32_t, uint32_t>> &edges) const;
 
 public:
 
-    bool add(T data);
-    bool connect(T node1, T node2, W weight);
-    W* getWeight(T node1, T node2);
-    void getWeight(T node1, T node2, W &target);
-    std::map<T, W> getWeights(T node);
-    std::vector<T> topologicalSort();
+    Graph();
+    explicit Graph(const A &allocator);
+
+    bool add(const T &data);
+    bool add(T &&data);
+    bool add(const T &data, nodeId &id);
+    bool add(T &&data, nodeId &id);
+    bool getId(const T &data, nodeId &id) const;
+    const T& getData(nodeId id) const;
+    size_t size() const;
+
+    bool connect(const T &node1, const T &node2, const W &weight);
+    bool connect(const T &node1, const T &node2, W &&weight);
+    bool connect(nodeId node1, nodeId node2, const W &weight);
+    bool connect(nodeId node1, nodeId node2, W &&weight);
+    bool connectUnchecked(const T &node1, const T &node2, const W &weight);
+    bool connectUnchecked(const T &node1, const T &node2, W &&weight);
+    bool connectUnchecked(nodeId node1, nodeId node2, const W &weight);
+    bool connectUnchecked(nodeId node1, nodeId node2, W &&weight);
+    bool validate();
+    bool build(const std::vector<T> &data, std::vector<std::tuple<T, T, W>> edges);
+    bool build(std::vector<std::tuple<nodeId, nodeId, W>> edges);
+    bool canConnect(std::vector<std::pair<nodeId, nodeId>> edges) const;
+    W* getWeight(const T &node1, const T &node2);
+    W* getWeight(nodeId node1, nodeId node2);
+    void getWeight(const T &node1, const T &node2, W &target);
+    void getWeight(nodeId node1, nodeId node2, W &target);
+    W* findWeight(const T &node1, const T &node2);
+    W* findWeight(nodeId node1, nodeId node2);
+    const W* findWeight(nodeId node1, nodeId node2) const;
+    template <typename F>
+    bool modifyWeight(const T &node1, const T &node2, F&& mutator);
+    template <typename F>
+    bool modifyWeight(nodeId node1, nodeId node2, F&& mutator);
+    std::map<T, W> getWeights(const T &node);
+    std::map<nodeId, W> getWeights(nodeId node);
+    std::map<T, W> getParentWeights(const T &node);
+    std::map<nodeId, W> getParentWeights(nodeId node);
+    template <typename F>
+    void forEachChild(nodeId node, F&& visitor) const;
+    template <typename F>
+    void forEachParent(nodeId node, F&& visitor) const;
+    std::vector<T> topologicalSort() const;
+    void topologicalSort(std::vector<nodeId> &ordering) const;
+    const std::vector<nodeId>& topologicalOrder() const;
+
+    FrozenGraph<T, W> freeze() const;
 
 };
 
-template <typename T, typename W>
-bool Graph<T, W>::add(T data) {
+template <typename T, typename W, typename A>
+Graph<T, W, A>::Graph() : Graph(A()) {}
+
+template <typename T, typename W, typename A>
+Graph<T, W, A>::Graph(const A &allocator) : allocator(allocator), nodes(nodeAllocator(allocator)), ids(idAllocator(allocator)) {}
+
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::add(const T &data) {
+
+    nodeId id;
+    return intern(data, id);
 
-    typename std::map<T, node<T, W>>::iterator existing = nodes.find(data);
+}
+
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::add(T &&data) {
+
+    nodeId id;
+    return intern(std::move(data), id);
+
+}
+
+/**
+ * Interns data as a new node.
+ *
+ * @param data The data to add.
+ * @param id Set to the handle of the node holding the data, whether
+ * it was just added or already present.
+ * @return False if the data was already present in the graph.
+ */
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::add(const T &data, nodeId &id) {
+    return intern(data, id);
+}
 
-    if (existing != nodes.end()) {
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::add(T &&data, nodeId &id) {
+    return intern(std::move(data), id);
+}
+
+template <typename T, typename W, typename A>
+template <typename D>
+bool Graph<T, W, A>::intern(D &&data, nodeId &id) {
+
+    auto existing = ids.find(data);
+
+    if (existing != ids.end()) {
+
+        id.index = existing->second;
         return false;
+
     }
 
-    node<T, W>* newNode = new node<T, W>;
-    newNode->data = data;
+    id.index = (uint32_t) nodes.size();
 
-    nodes[data] = *newNode;
+    ids.insert(std::pair<T, uint32_t>(data, id.index));
+    nodes.emplace_back(std::forward<D>(data), allocator);
+
+    positions.push_back((uint32_t) ordering.size());
+    ordering.push_back(id);
+    visited.push_back(0);
 
     return true;
 
 }
 
-template <typename T, typename W>
-bool Graph<T, W>::connect(T node1, T node2, W weight) {
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::getId(const T &data, nodeId &id) const {
+
+    auto existing = ids.find(data);
+
+    if (existing == ids.end()) {
+        return false;
+    }
+
+    id.index = existing->second;
+
+    return true;
+
+}
+
+template <typename T, typename W, typename A>
+const T& Graph<T, W, A>::getData(nodeId id) const {
+    return nodes[id.index].data;
+}
+
+/**
+ * @return The number of nodes in the graph. Handles run from zero up
+ * to, but not including, this number.
+ */
+template <typename T, typename W, typename A>
+size_t Graph<T, W, A>::size() const {
+    return nodes.size();
+}
+
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::connect(const T &node1, const T &node2, const W &weight) {
+
+    nodeId id1, id2;
+
+    if (!getId(node1, id1) || !getId(node2, id2)) {
+        return false;
+    }
+
+    return connectEdge(id1, id2, weight);
+
+}
+
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::connect(const T &node1, const T &node2, W &&weight) {
+
+    nodeId id1, id2;
+
+    if (!getId(node1, id1) || !getId(node2, id2)) {
+        return false;
+    }
+
+    return connectEdge(id1, id2, std::move(weight));
+
+}
+
+/**
+ * Connects two nodes, or updates the weight of the edge if they are
+ * already connected. The topological order is repaired as part of
+ * adding the edge, which also catches edges that would close a cycle
+ * while only visiting the nodes positioned between the two.
+ *
+ * @return False if either node is missing, or if the edge would make
+ * the graph cyclic, in which case it is not added.
+ */
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::connect(nodeId node1, nodeId node2, const W &weight) {
+    return connectEdge(node1, node2, weight);
+}
+
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::connect(nodeId node1, nodeId node2, W &&weight) {
+    return connectEdge(node1, node2, std::move(weight));
+}
+
+template <typename T, typename W, typename A>
+template <typename V>
+bool Graph<T, W, A>::connectEdge(nodeId node1, nodeId node2, V &&weight) {
+
+    if (node1.index >= nodes.size() || node2.index >= nodes.size()) {
+        return false;
+    }
+
+    uint32_t position;
+
+    if (edgeIndex.find(node1.index, node2.index, position)) {
+
+        nodes[node1.index].edges[position].weight = std::forward<V>(weight);
+        return true;
+
+    }
+
+    if (!ordered && !validate()) {
+        return false;
+    }
+
+    if (!reorder(node1.index, node2.index)) {
+        return false;
+    }
+
+    insertEdge(node1.index, node2.index, std::forward<V>(weight));
+
+    return true;
+}
+
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::connectUnchecked(const T &node1, const T &node2, const W &weight) {
+
+    nodeId id1, id2;
+
+    if (!getId(node1, id1) || !getId(node2, id2)) {
+        return false;
+    }
+
+    return connectEdgeUnchecked(id1, id2, weight);
+
+}
+
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::connectUnchecked(const T &node1, const T &node2, W &&weight) {
+
+    nodeId id1, id2;
+
+    if (!getId(node1, id1) || !getId(node2, id2)) {
+        return false;
+    }
+
+    return connectEdgeUnchecked(id1, id2, std::move(weight));
+
+}
+
+/**
+ * Connects two nodes without maintaining the topological order or
+ * checking for cycles, for loading many edges at once. The order is
+ * left stale until validate is called, which should be done once
+ * all edges are in.
+ *
+ * @return False if either node is missing.
+ */
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::connectUnchecked(nodeId node1, nodeId node2, const W &weight) {
+    return connectEdgeUnchecked(node1, node2, weight);
+}
+
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::connectUnchecked(nodeId node1, nodeId node2, W &&weight) {
+    return connectEdgeUnchecked(node1, node2, std::move(weight));
+}
+
+template <typename T, typename W, typename A>
+template <typename V>
+bool Graph<T, W, A>::connectEdgeUnchecked(nodeId node1, nodeId node2, V &&weight) {
+
+    if (node1.index >= nodes.size() || node2.index >= nodes.size()) {
+        return false;
+    }
+
+    uint32_t position;
+
+    if (edgeIndex.find(node1.index, node2.index, position)) {
+
+        nodes[node1.index].edges[position].weight = std::forward<V>(weight);
+        return true;
+
+    }
+
+    insertEdge(node1.index, node2.index, std::forward<V>(weight));
+    ordered = false;
+
+    return true;
+
+}
+
+/**
+ * Rebuilds the topological order from scratch, which is needed after
+ * edges have been added through connectUnchecked.
+ *
+ * @return False if the graph has a cycle. The order then only holds
+ * the nodes that do not depend on the cycle, and connect will refuse
+ * new edges until the graph validates.
+ */
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::validate() {
+
+    computeOrdering(ordering);
+
+    if (ordering.size() != nodes.size()) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < ordering.size(); ++i) {
+        positions[ordering[i].index] = i;
+    }
+
+    ordered = true;
+
+    return true;
+
+}
+
+/**
+ * Adds many nodes and edges in one go. Storage for all of them is
+ * reserved up front, edges are grouped by source and target so that
+ * every edge and parent list is filled in a single pass, and the
+ * topological order is computed once. Edges to nodes that are already
+ * connected update the weight; if the same pair appears more than once
+ * the last weight wins.
+ *
+ * @param data The data of the nodes to add. Data already in the graph
+ * is skipped.
+ * @param edges Triples of source data, target data and weight. The
+ * weights are moved out of the list.
+ * @return False if an edge refers to data that is not in the graph,
+ * in which case that edge is skipped, or if the edges would make the
+ * graph cyclic, in which case none of them are added. The nodes are
+ * added either way.
+ */
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::build(const std::vector<T> &data, std::vector<std::tuple<T, T, W>> edges) {
+
+    bool complete = true;
+
+    nodes.reserve(nodes.size() + data.size());
+    ids.reserve(ids.size() + data.size());
+    positions.reserve(positions.size() + data.size());
+    ordering.reserve(ordering.size() + data.size());
+    visited.reserve(visited.size() + data.size());
+
+    nodeId id;
+
+    for (auto const& it : data) {
+        add(it, id);
+    }
+
+    std::vector<std::tuple<nodeId, nodeId, W>> resolved;
+    resolved.reserve(edges.size());
+
+    nodeId source, target;
+
+    for (auto& it : edges) {
+
+        if (!getId(std::get<0>(it), source) || !getId(std::get<1>(it), target)) {
+
+            complete = false;
+            continue;
+
+        }
+
+        resolved.emplace_back(source, target, std::move(std::get<2>(it)));
+
+    }
+
+    return build(std::move(resolved)) && complete;
+
+}
+
+/**
+ * Adds many edges between nodes already in the graph in one go, as
+ * build does for node data. The edges are checked for cycles before
+ * any of them is added, so a failed build leaves the graph as it was.
+ *
+ * @param edges Triples of source, target and weight. The weights are
+ * moved out of the list.
+ * @return False if an edge refers to a node that is not in the graph,
+ * in which case that edge is skipped, or if the edges would make the
+ * graph cyclic, in which case none of them are added.
+ */
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::build(std::vector<std::tuple<nodeId, nodeId, W>> edges) {
+
+    bool complete = true;
+
+    std::vector<uint32_t> order;
+    order.reserve(edges.size());
+
+    for (uint32_t i = 0; i < edges.size(); ++i) {
+
+        if (std::get<0>(edges[i]).index >= nodes.size() || std::get<1>(edges[i]).index >= nodes.size()) {
+
+            complete = false;
+            continue;
+
+        }
+
+        order.push_back(i);
+
+    }
+
+    std::sort(order.begin(), order.end(), [&edges] (uint32_t first, uint32_t second) {
 
-    typename std::map<T, node<T, W>>::iterator existing1 = nodes.find(node1);
-    typename std::map<T, node<T, W>>::iterator existing2 = nodes.find(node2);
+        uint32_t firstSource = std::get<0>(edges[first]).index, secondSource = std::get<0>(edges[second]).index;
+        uint32_t firstTarget = std::get<1>(edges[first]).index, secondTarget = std::get<1>(edges[second]).index;
 
-    /*if (existing1 == nodes.end() || existing2 == nodes.end() || areConnected(existing1->second, existing2->second)) {
+        return firstSource != secondSource ? firstSource < secondSource
+             : firstTarget != secondTarget ? firstTarget < secondTarget
+             : first < second;
+
+    });
+
+    /*
+     * Only the last of each run of equal pairs is kept, and pairs that
+     * are already connected only have their weight updated.
+     */
+    std::vector<uint32_t> kept;
+    std::vector<std::pair<uint32_t, uint32_t>> added;
+
+    kept.reserve(order.size());
+    added.reserve(order.size());
+
+    for (size_t i = 0; i < order.size(); ++i) {
+
+        uint32_t source = std::get<0>(edges[order[i]]).index;
+        uint32_t target = std::get<1>(edges[order[i]]).index;
+
+        if (i + 1 < order.size() && std::get<0>(edges[order[i + 1]]).index == source && std::get<1>(edges[order[i + 1]]).index == target) {
+            continue;
+        }
+
+        kept.push_back(order[i]);
+
+        if (!areConnected(source, target)) {
+            added.emplace_back(source, target);
+        }
+    }
+
+    std::vector<nodeId> sorted;
+
+    if (!computeOrdering(added, sorted)) {
         return false;
-    }*/
-    if (existing1 == nodes.end() || existing2 == nodes.end()) {
+    }
+
+    std::vector<uint32_t> outgoing(nodes.size()), incoming(nodes.size());
+
+    for (auto const& it : added) {
+
+        ++outgoing[it.first];
+        ++incoming[it.second];
+
+    }
+
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+
+        nodes[i].edges.reserve(nodes[i].edges.size() + outgoing[i]);
+        nodes[i].parents.reserve(nodes[i].parents.size() + incoming[i]);
+
+    }
+
+    edgeIndex.reserve(edgeIndex.size() + added.size());
+
+    for (auto const& it : kept) {
+
+        uint32_t source = std::get<0>(edges[it]).index;
+        uint32_t target = std::get<1>(edges[it]).index;
+        W& weight = std::get<2>(edges[it]);
+        uint32_t position;
+
+        if (edgeIndex.find(source, target, position)) {
+            nodes[source].edges[position].weight = std::move(weight);
+        } else {
+            insertEdge(source, target, std::move(weight));
+        }
+    }
+
+    ordering = std::move(sorted);
+
+    for (uint32_t i = 0; i < ordering.size(); ++i) {
+        positions[ordering[i].index] = i;
+    }
+
+    ordered = true;
+
+    return complete;
+
+}
+
+/**
+ * Checks whether a set of edges could be added without making the graph
+ * cyclic, without adding them.
+ *
+ * @param edges Pairs of source and target. Pairs that are already
+ * connected, listed twice or refer to nodes not in the graph are
+ * ignored.
+ * @return False if adding the edges would make the graph cyclic.
+ */
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::canConnect(std::vector<std::pair<nodeId, nodeId>> edges) const {
+
+    std::vector<std::pair<uint32_t, uint32_t>> added;
+    added.reserve(edges.size());
+
+    for (auto const& it : edges) {
+        if (it.first.index < nodes.size() && it.second.index < nodes.size()) {
+            added.emplace_back(it.first.index, it.second.index);
+        }
+    }
+
+    newEdges(added);
+
+    std::vector<nodeId> sorted;
+
+    return computeOrdering(added, sorted);
+
+}
+
+/*
+ * Sorts pairs of node indices by source and target and drops those that
+ * are listed twice or already connected.
+ */
+template <typename T, typename W, typename A>
+void Graph<T, W, A>::newEdges(std::vector<std::pair<uint32_t, uint32_t>> &edges) const {
+
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    uint32_t position;
+
+    edges.erase(std::remove_if(edges.begin(), edges.end(), [this, &position] (const std::pair<uint32_t, uint32_t>& it) {
+        return edgeIndex.find(it.first, it.second, position);
+    }), edges.end());
+
+}
+
+template <typename T, typename W, typename A>
+void Graph<T, W, A>::insertEdge(uint32_t source, uint32_t target, W weight) {
+
+    edgeList &edges = nodes[source].edges;
+
+    edge<T, W> connection;
+
+    connection.target = target;
+    connection.weight = std::move(weight);
+
+    edgeIndex.insert(source, target, (uint32_t) edges.size());
+    edges.push_back(std::move(connection));
+    nodes[target].parents.push_back(inEdge{source, (uint32_t) edges.size() - 1});
+
+}
+
+/*
+ * Updates the topological order ahead of adding an edge from source
+ * to target, following Pearce and Kelly's dynamic topological sort.
+ * Only the nodes positioned between target and source are visited:
+ * those reachable from target and those reaching source. The two sets
+ * are then written back into the positions they already occupied,
+ * everything reaching source first.
+ *
+ * Returns false, leaving the order untouched, if the edge would
+ * close a cycle.
+ */
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::reorder(uint32_t source, uint32_t target) {
+
+    if (source == target) {
         return false;
     }
 
-    std::vector<edge<T, W>> &edges = existing1->second.edges;
+    uint32_t lower = positions[target];
+    uint32_t upper = positions[source];
+
+    if (lower > upper) {
+        return true;
+    }
+
+    forward.clear();
+    backward.clear();
+
+    bool closesCycle = false;
 
-    edge<T, W>* connection;
+    stack.push_back(target);
+    visited[target] = 1;
 
-    for (auto iter = edges.begin(); iter != edges.end(); ++iter) {
+    while (!stack.empty() && !closesCycle) {
 
-        if (iter->target->data == existing2->second.data) {
+        uint32_t current = stack.back();
+        stack.pop_back();
 
-            connection = &(*iter);
-            connection->weight = weight;
+        forward.push_back(current);
 
-            return true;
+        for (auto const& it : nodes[current].edges) {
 
+            if (it.target == source) {
+                closesCycle = true;
+                break;
+            }
+
+            if (!visited[it.target] && positions[it.target] < upper) {
+
+                visited[it.target] = 1;
+                stack.push_back(it.target);
+
+            }
         }
     }
 
-    connection = new edge<T, W>;
+    if (!closesCycle) {
+
+        stack.push_back(source);
+        visited[source] = 1;
+
+        while (!stack.empty()) {
+
+            uint32_t current = stack.back();
+            stack.pop_back();
+
+            backward.push_back(current);
+
+            for (auto const& parent : nodes[current].parents) {
+
+                if (!visited[parent.source] && positions[parent.source] > lower) {
+
+                    visited[parent.source] = 1;
+                    stack.push_back(parent.source);
+
+                }
+            }
+        }
+    }
+
+    for (auto const& it : stack) {
+        visited[it] = 0;
+    }
+
+    for (auto const& it : forward) {
+        visited[it] = 0;
+    }
+
+    for (auto const& it : backward) {
+        visited[it] = 0;
+    }
+
+    stack.clear();
+
+    if (closesCycle) {
+        return false;
+    }
+
+    auto byPosition = [this](uint32_t first, uint32_t second) {
+        return positions[first] < positions[second];
+    };
+
+    std::sort(forward.begin(), forward.end(), byPosition);
+    std::sort(backward.begin(), backward.end(), byPosition);
+
+    slots.clear();
+
+    for (auto const& it : backward) {
+        slots.push_back(positions[it]);
+    }
+
+    for (auto const& it : forward) {
+        slots.push_back(positions[it]);
+    }
+
+    std::sort(slots.begin(), slots.end());
+
+    size_t next = 0;
+
+    for (auto const& it : backward) {
+
+        positions[it] = slots[next++];
+        ordering[positions[it]] = nodeId{it};
+
+    }
+
+    for (auto const& it : forward) {
 
-    connection->target = &existing2->second;
-    connection->weight = weight;
+        positions[it] = slots[next++];
+        ordering[positions[it]] = nodeId{it};
 
-    existing1->second.edges.push_back(*connection);
-    existing2->second.indegree++;
+    }
 
     return true;
+
 }
 
-template <typename T, typename W>
-std::vector<T> Graph<T, W>::topologicalSort() {
+template <typename T, typename W, typename A>
+std::vector<T> Graph<T, W, A>::topologicalSort() const {
 
     std::vector<T> topologicalOrdering;
-    std::map<T, int> indegrees;
-    std::queue<node<T, W>> queue;
+    topologicalOrdering.reserve(ordering.size());
 
-    for (auto const& it : nodes) {
+    for (auto const& id : ordering) {
+        topologicalOrdering.push_back(nodes[id.index].data);
+    }
 
-        if (it.second.indegree == 0) {
-            queue.push(it.second);
-        } else {
-            indegrees[it.second.data] = it.second.indegree;
+    return topologicalOrdering;
+
+}
+
+template <typename T, typename W, typename A>
+void Graph<T, W, A>::topologicalSort(std::vector<nodeId> &target) const {
+    target = ordering;
+}
+
+/**
+ * Gives access to the topological order that is maintained as edges
+ * are added, without copying it. Edges added through connectUnchecked
+ * are only reflected once validate has been called.
+ */
+template <typename T, typename W, typename A>
+const std::vector<nodeId>& Graph<T, W, A>::topologicalOrder() const {
+    return ordering;
+}
+
+template <typename T, typename W, typename A>
+void Graph<T, W, A>::computeOrdering(std::vector<nodeId> &target) const {
+    computeOrdering(std::vector<std::pair<uint32_t, uint32_t>>(), target);
+}
+
+/*
+ * Kahn's algorithm over the edges of the graph along with a list of
+ * edges not yet added, sorted by source, none of them already in the
+ * graph. Returns false if the edges together have a cycle, in which
+ * case the order only holds the nodes that do not depend on it.
+ */
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::computeOrdering(const std::vector<std::pair<uint32_t, uint32_t>> &added, std::vector<nodeId> &target) const {
+
+    target.clear();
+    target.reserve(nodes.size());
+
+    std::vector<size_t> indegrees(nodes.size());
+    std::vector<size_t> first(nodes.size() + 1, 0);
+    std::queue<uint32_t> queue;
+
+    for (auto const& it : added) {
+
+        ++indegrees[it.second];
+        ++first[it.first + 1];
+
+    }
+
+    for (uint32_t i = 0; i < nodes.size(); ++i) {
+
+        first[i + 1] += first[i];
+        indegrees[i] += nodes[i].parents.size();
+
+        if (indegrees[i] == 0) {
+            queue.push(i);
         }
     }
 
     while (!queue.empty()) {
 
-        node<T, W> n = queue.front();
+        uint32_t n = queue.front();
         queue.pop();
 
-        topologicalOrdering.push_back(n.data);
+        target.push_back(nodeId{n});
 
-        for (auto const& it : n.edges) {
+        for (auto const& it : nodes[n].edges) {
 
-            int* indegree = &indegrees[it.target->data];
+            if (--indegrees[it.target] == 0) {
+                queue.push(it.target);
+            }
+        }
 
-            if (--*indegree == 0) {
-                queue.push(*it.target);
+        for (size_t i = first[n]; i < first[n + 1]; ++i) {
+
+            if (--indegrees[added[i].second] == 0) {
+                queue.push(added[i].second);
             }
         }
     }
-    return topologicalOrdering;
+
+    return target.size() == nodes.size();
 
 }
 
-template <typename T, typename W>
-bool Graph<T, W>::areConnected(node<T, W> first, node<T, W> second) {
+template <typename T, typename W, typename A>
+bool Graph<T, W, A>::areConnected(uint32_t first, uint32_t second) {
 
-    std::vector<edge<T, W>> &edges = first.edges;
-    auto it = std::find_if(edges.begin(), edges.end(), [&second](const edge<T, W>& edge) {
-        return edge.target->data == second.data;
-    });
+    uint32_t position;
+    return edgeIndex.find(first, second, position);
+
+}
+
+template <typename T, typename W, typename A>
+typename Graph<T, W, A>::edgeList::iterator Graph<T, W, A>::getConnection(uint32_t first, uint32_t second) {
+
+    edgeList &edges = nodes[first].edges;
+    uint32_t position;
+
+    if (!edgeIndex.find(first, second, position)) {
+        return edges.end();
+    }
 
-    return it != edges.end();
-    /*edge<T, W> edge = getConnection(first, second);
-    return edge != first.edges.end();*/
+    return edges.begin() + position;
 
 }
 
-template<typename T, typename W>
-typename std::vector<edge<T, W>>::iterator Graph<T, W>::getConnection(node<T, W> first, node<T, W> second) {
+template <typename T, typename W, typename A>
+W* Graph<T, W, A>::getWeight(const T &node1, const T &node2) {
 
-    std::vector<edge<T, W>> &edges = first.edges;
+    nodeId id1, id2;
 
-    auto it = std::find_if(edges.begin(), edges.end(), [&second](const edge<T, W>& edge) {
-        return edge.target->data == second.data;
-    });
+    if (!getId(node1, id1) || !getId(node2, id2)) {
+        return NULL;
+    }
 
-    return it;
+    return getWeight(id1, id2);
 
 }
 
-template<typename T, typename W>
-W* Graph<T, W>::getWeight(T node1, T node2) {
+template <typename T, typename W, typename A>
+W* Graph<T, W, A>::getWeight(nodeId node1, nodeId node2) {
 
-    W* weight = NULL;
+    if (node1.index >= nodes.size() || node2.index >= nodes.size()) {
+        return NULL;
+    }
 
-    typename std::map<T, node<T, W>>::iterator existing1 = nodes.find(node1);
-    typename std::map<T, node<T, W>>::iterator existing2 = nodes.find(node2);
+    typename edgeList::iterator edgeIter = getConnection(node1.index, node2.index);
 
-    if (existing1 == nodes.end() || existing2 == nodes.end() || !areConnected(existing1->second, existing2->second)) {
+    if (edgeIter == nodes[node1.index].edges.end()) {
         return NULL;
     }
 
-    weight = new W();
+    return new W(edgeIter->weight);
+
+}
 
-    std::vector<edge<T, W>> &edges = existing1->second.edges;
+template <typename T, typename W, typename A>
+void Graph<T, W, A>::getWeight(const T &node1, const T &node2, W& target) {
 
-    for (auto iter = edges.begin(); iter != edges.end(); ++iter) {
+    nodeId id1, id2;
 
-        edge<T, W> edge = *iter;
-        if (edge.target->data == existing2->second.data) {
-            *weight = edge.weight;
-            break;
-        }
+    if (!getId(node1, id1) || !getId(node2, id2)) {
+        return;
     }
 
-    return weight;
+    getWeight(id1, id2, target);
 
 }
 
-template<typename T, typename W>
-void Graph<T, W>::getWeight(T node1, T node2, W& target) {
+template <typename T, typename W, typename A>
+void Graph<T, W, A>::getWeight(nodeId node1, nodeId node2, W& target) {
 
-    typename std::map<T, node<T, W>>::iterator existing1 = nodes.find(node1);
-    typename std::map<T, node<T, W>>::iterator existing2 = nodes.find(node2);
-
-    if (existing1 == nodes.end() || existing2 == nodes.end() || !areConnected(existing1->second, existing2->second)) {
+    if (node1.index >= nodes.size() || node2.index >= nodes.size()) {
         return;
     }
 
-    typename std::vector<edge<T, W>>::iterator edgeIter = getConnection(existing1->second, existing2->second);
+    typename edgeList::iterator edgeIter = getConnection(node1.index, node2.index);
+
+    if (edgeIter != nodes[node1.index].edges.end()) {
+        target = edgeIter->weight;
+    }
+
+}
+
+/**
+ * Gives direct access to the weight stored on an edge, without
+ * copying it.
+ *
+ * @return A pointer to the stored weight, or NULL if the nodes are
+ * not connected. The pointer stays valid until another edge is
+ * added to the first node.
+ */
+template <typename T, typename W, typename A>
+W* Graph<T, W, A>::findWeight(const T &node1, const T &node2) {
+
+    nodeId id1, id2;
+
+    if (!getId(node1, id1) || !getId(node2, id2)) {
+        return NULL;
+    }
+
+    return findWeight(id1, id2);
+
+}
+
+template <typename T, typename W, typename A>
+W* Graph<T, W, A>::findWeight(nodeId node1, nodeId node2) {
+
+    const Graph<T, W, A>* self = this;
+    return const_cast<W*>(self->findWeight(node1, node2));
+
+}
+
+template <typename T, typename W, typename A>
+const W* Graph<T, W, A>::findWeight(nodeId node1, nodeId node2) const {
 
-    target = edgeIter->weight;
+    uint32_t position;
+
+    if (node1.index >= nodes.size() || !edgeIndex.find(node1.index, node2.index, position)) {
+        return NULL;
+    }
+
+    return &nodes[node1.index].edges[position].weight;
 
 }
 
-template<typename T, typename W>
-std::map<T, W> Graph<T, W>::getWeights(T nodeKey) {
+/**
+ * Changes the weight stored on an edge in place.
+ *
+ * @param mutator Called with a reference to the stored weight.
+ * @return False if the nodes are not connected, in which case the
+ * mutator is not called.
+ */
+template <typename T, typename W, typename A>
+template<typename F>
+bool Graph<T, W, A>::modifyWeight(const T &node1, const T &node2, F&& mutator) {
 
-    typename std::map<T, node<T, W>>::iterator existing = nodes.find(nodeKey);
+    W* weight = findWeight(node1, node2);
+
+    if (weight == NULL) {
+        return false;
+    }
+
+    mutator(*weight);
+
+    return true;
+
+}
+
+template <typename T, typename W, typename A>
+template<typename F>
+bool Graph<T, W, A>::modifyWeight(nodeId node1, nodeId node2, F&& mutator) {
+
+    W* weight = findWeight(node1, node2);
+
+    if (weight == NULL) {
+        return false;
+    }
+
+    mutator(*weight);
+
+    return true;
+
+}
+
+template <typename T, typename W, typename A>
+std::map<T, W> Graph<T, W, A>::getWeights(const T &nodeKey) {
 
     std::map<T, W> weights;
+    nodeId id;
 
-    std::for_each(existing->second.edges.begin(), existing->second.edges.end(), [&weights] (edge<T, W> currentEdge) {
-        weights.insert(std::pair<T, W>(currentEdge.target->data, currentEdge.weight));
-    });
+    if (!getId(nodeKey, id)) {
+        return weights;
+    }
+
+    for (auto const& currentEdge : nodes[id.index].edges) {
+        weights.insert(std::pair<T, W>(nodes[currentEdge.target].data, currentEdge.weight));
+    }
+
+    return weights;
+
+};
+
+template <typename T, typename W, typename A>
+std::map<nodeId, W> Graph<T, W, A>::getWeights(nodeId nodeKey) {
+
+    std::map<nodeId, W> weights;
+
+    if (nodeKey.index >= nodes.size()) {
+        return weights;
+    }
+
+    for (auto const& currentEdge : nodes[nodeKey.index].edges) {
+        weights.insert(std::pair<nodeId, W>(nodeId{currentEdge.target}, currentEdge.weight));
+    }
 
     return weights;
 
 };
 
+template <typename T, typename W, typename A>
+std::map<T, W> Graph<T, W, A>::getParentWeights(const T &nodeKey) {
+
+    std::map<T, W> weights;
+    nodeId id;
+
+    if (!getId(nodeKey, id)) {
+        return weights;
+    }
+
+    forEachParent(id, [this, &weights] (nodeId parent, const W& weight) {
+        weights.insert(std::pair<T, W>(nodes[parent.index].data, weight));
+    });
+
+    return weights;
+
+}
+
+template <typename T, typename W, typename A>
+std::map<nodeId, W> Graph<T, W, A>::getParentWeights(nodeId nodeKey) {
+
+    std::map<nodeId, W> weights;
+
+    if (nodeKey.index >= nodes.size()) {
+        return weights;
+    }
+
+    forEachParent(nodeKey, [&weights] (nodeId parent, const W& weight) {
+        weights.insert(std::pair<nodeId, W>(parent, weight));
+    });
+
+    return weights;
+
+}
+
+/**
+ * Visits the children of a node in the order they were connected.
+ *
+ * @param visitor Called with the handle of each child and the weight
+ * of the edge leading to it.
+ */
+template <typename T, typename W, typename A>
+template<typename F>
+void Graph<T, W, A>::forEachChild(nodeId nodeKey, F&& visitor) const {
+
+    for (auto const& it : nodes[nodeKey.index].edges) {
+        visitor(nodeId{it.target}, it.weight);
+    }
+}
+
+/**
+ * Visits the parents of a node in the order they were connected,
+ * following the links kept on the node instead of searching the
+ * graph, so this is linear in the number of parents.
+ *
+ * @param visitor Called with the handle of each parent and the
+ * weight of the edge leading from it.
+ */
+template <typename T, typename W, typename A>
+template<typename F>
+void Graph<T, W, A>::forEachParent(nodeId nodeKey, F&& visitor) const {
+
+    for (auto const& it : nodes[nodeKey.index].parents) {
+        visitor(nodeId{it.source}, nodes[it.source].edges[it.position].weight);
+    }
+}
+
+/**
+ * Takes an immutable snapshot of the graph laid out for traversal.
+ * The snapshot shares node handles with the graph but not storage,
+ * so the graph can keep changing afterwards without affecting it.
+ */
+template <typename T, typename W, typename A>
+FrozenGraph<T, W> Graph<T, W, A>::freeze() const {
+
+    FrozenGraph<T, W> frozen;
+
+    size_t edgeCount = edgeIndex.size();
+
+    frozen.data.reserve(nodes.size());
+    frozen.ids.insert(ids.begin(), ids.end());
+    frozen.offsets.reserve(nodes.size() + 1);
+    frozen.targets.reserve(edgeCount);
+    frozen.weights.reserve(edgeCount);
+
+    std::vector<uint32_t> order;
+
+    frozen.offsets.push_back(0);
+
+    for (auto const& current : nodes) {
+
+        frozen.data.push_back(current.data);
+
+        /*
+         * Children are laid out sorted by index so that single
+         * edges can be looked up with a binary search.
+         */
+        order.resize(current.edges.size());
+
+        for (uint32_t i = 0; i < order.size(); ++i) {
+            order[i] = i;
+        }
+
+        std::sort(order.begin(), order.end(), [&current](uint32_t first, uint32_t second) {
+            return current.edges[first].target < current.edges[second].target;
+        });
+
+        for (auto const& i : order) {
+
+            frozen.targets.push_back(current.edges[i].target);
+            frozen.weights.push_back(current.edges[i].weight);
+
+        }
+
+        frozen.offsets.push_back((uint32_t) frozen.targets.size());
+
+    }
+
+    frozen.index();
+    topologicalSort(frozen.ordering);
+
+    return frozen;
+
+}
+
 #endif //GRAPH_GRAPH_H
@@ -0,0 +1,32 @@
+#ifndef GRAPH_NODEID_H
+#define GRAPH_NODEID_H
+
+#include <cstdint>
+
+/**
+ * Dense handle to a node in a graph. Handles are handed out when
+ * data is interned by Graph::add and index straight into the node
+ * storage, so operations taking handles never have to hash or
+ * compare the data itself. Kept as a distinct type so that the
+ * handle based overloads can not be mixed up with the data based
+ * ones, even for integral data.
+ */
+struct nodeId {
+
+    uint32_t index;
+
+};
+
+inline bool operator==(nodeId first, nodeId second) {
+    return first.index == second.index;
+}
+
+inline bool operator!=(nodeId first, nodeId second) {
+    return first.index != second.index;
+}
+
+inline bool operator<(nodeId first, nodeId second) {
+    return first.index < second.index;
+}
+
+#endif //GRAPH_NODEID_H
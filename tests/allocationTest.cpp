@@ -0,0 +1,96 @@
+#include "catch.h"
+#include "armadillo"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "../bayesNet/BayesianNetwork.h"
+
+/*
+ * Count every allocation made through operator new in the test binary,
+ * so that hot paths can be checked for steady state allocations.
+ * Armadillo allocates element storage on its own, but matrices as
+ * small as the ones used below live inside the matrix object.
+ */
+static std::atomic<size_t> allocations(0);
+
+void* operator new(size_t size) {
+
+    ++allocations;
+
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+
+    if (pointer == NULL) {
+        throw std::bad_alloc();
+    }
+
+    return pointer;
+
+}
+
+void operator delete(void* pointer) noexcept {
+    std::free(pointer);
+}
+
+TEST_CASE("Recording does not allocate once an edge exists", "[allocation]") {
+
+    BayesianNetwork bayesNet(3);
+
+    const std::string hidden = "T";
+    const std::string visible = "E0";
+
+    nodeId hiddenId, visibleId;
+
+    REQUIRE(bayesNet.add(hidden, hiddenId));
+    REQUIRE(bayesNet.add(visible, visibleId));
+    REQUIRE(bayesNet.record(hidden, visible, 0, 0));
+
+    const arma::uword hiddenStates[] = {0, 1, 2, 2};
+    const arma::uword visibleStates[] = {2, 1, 0, 0};
+
+    size_t before = allocations;
+    bool recorded = true;
+
+    for (arma::uword i = 0; i < 1000; ++i) {
+
+        recorded &= bayesNet.record(hidden, visible, i % 3, (i + 1) % 3);
+        recorded &= bayesNet.record(hiddenId, visibleId, i % 3, (i + 2) % 3);
+        recorded &= bayesNet.record(hiddenId, visibleId, i % 3, i % 3, 0.5);
+        recorded &= bayesNet.erase(hiddenId, visibleId, i % 3, (i + 2) % 3);
+        recorded &= bayesNet.recordBatch(hiddenId, visibleId, hiddenStates, visibleStates, 4);
+
+    }
+
+    size_t after = allocations;
+
+    REQUIRE(recorded);
+    REQUIRE(after == before);
+
+}
+
+TEST_CASE("Imputing into an existing vector does not allocate", "[allocation]") {
+
+    BayesianNetwork bayesNet(3);
+
+    arma::rowvec thetaHidden = {0.25, 0.40, 0.35};
+    arma::mat thetaVisible = { {0.33, 0.40, 0.50},
+                               {0.65, 0.20, 0.10} };
+
+    arma::rowvec reference = bayesNet.imputeHiddenNode(thetaHidden, thetaVisible);
+    arma::rowvec final = reference;
+
+    size_t before = allocations;
+
+    for (int i = 0; i < 1000; ++i) {
+        bayesNet.imputeHiddenNode(thetaHidden, thetaVisible, final);
+    }
+
+    size_t after = allocations;
+
+    REQUIRE(after == before);
+
+    for (arma::uword i = 0; i < final.n_elem; ++i) {
+        REQUIRE(final(i) == reference(i));
+    }
+
+}
@@ -0,0 +1,100 @@
+#include "catch.h"
+#include "armadillo"
+
+#include "../bayesNet/BayesianNetwork.h"
+#include "../bayesNet/BayesianNetworkFixed.h"
+
+TEST_CASE("Record in a fixed size network", "[bayesNetFixed]") {
+
+    BayesianNetworkFixed<3> bayesNet;
+    nodeId hidden, visible;
+
+    REQUIRE(bayesNet.add("T", hidden));
+    REQUIRE(bayesNet.add("E0", visible));
+
+    REQUIRE(!bayesNet.record(hidden, visible, 3, 0));
+    REQUIRE(bayesNet.record(hidden, visible, 2, 0));
+    REQUIRE(bayesNet.record("T", "E0", 2, 1));
+    REQUIRE(bayesNet.erase("T", "E0", 2, 1));
+    REQUIRE(!bayesNet.erase("T", "E0", 2, 1));
+    REQUIRE(!bayesNet.record("E0", "T", 0, 0));
+
+    std::map<std::string, BayesianNetworkFixed<3>::table> thetaVisible = bayesNet.computeThetaVisible("T");
+
+    REQUIRE(thetaVisible["E0"](0, 2) == Approx(1));
+    REQUIRE(thetaVisible["E0"](0, 1) == 0);
+
+    arma::mat values = bayesNet.get("T", { {"E0", 0} });
+
+    REQUIRE(values.n_rows == 1);
+    REQUIRE(values(0, 2) == 1);
+
+}
+
+TEST_CASE("Fixed size networks match dynamic ones", "[bayesNetFixed]") {
+
+    BayesianNetwork dynamic(3);
+    BayesianNetworkFixed<3> fixed;
+
+    arma::rowvec dataHidden = {0, 1, 2, 2, 1, 0, 2};
+    std::map<std::string, arma::rowvec> dataVisible = { {"E0", {1, 1, 0, 2, 2, 0, 0}},
+                                                        {"E1", {0, 0, 0, 1, 1, 2, 2}} };
+
+    SECTION("Compute theta hidden") {
+
+        arma::rowvec expected = dynamic.computeThetaHidden(dataHidden);
+        BayesianNetworkFixed<3>::distribution result = fixed.computeThetaHidden(dataHidden);
+
+        for (arma::uword i = 0; i < 3; ++i) {
+            REQUIRE(result(i) == Approx(expected(i)));
+        }
+    }
+
+    SECTION("Compute theta visible") {
+
+        std::map<std::string, arma::mat> expected = dynamic.computeThetaVisible(dataHidden, dataVisible);
+        std::map<std::string, BayesianNetworkFixed<3>::table> result = fixed.computeThetaVisible(dataHidden, dataVisible);
+
+        for (auto const& it : expected) {
+            for (arma::uword col = 0; col < 3; ++col) {
+                for (arma::uword row = 0; row < 3; ++row) {
+                    REQUIRE(result[it.first](row, col) == Approx(it.second(row, col)));
+                }
+            }
+        }
+    }
+
+    SECTION("Impute hidden node") {
+
+        arma::rowvec thetaHidden = {0.25, 0.40, 0.35};
+        BayesianNetworkFixed<3>::distribution fixedThetaHidden = {0.25, 0.40, 0.35};
+        arma::mat thetaVisible = { {0.33, 0.40, 0.50},
+                                   {0.65, 0.20, 0.10} };
+
+        arma::rowvec expected = dynamic.imputeHiddenNode(thetaHidden, thetaVisible);
+        BayesianNetworkFixed<3>::distribution result = fixed.imputeHiddenNode(fixedThetaHidden, thetaVisible);
+
+        for (arma::uword i = 0; i < 3; ++i) {
+            REQUIRE(result(i) == Approx(expected(i)));
+        }
+    }
+    SECTION("States outside the network are rejected") {
+
+        arma::rowvec outOfRange = {0, 3, 1};
+
+        REQUIRE_THROWS_AS(fixed.computeThetaHidden(outOfRange), std::out_of_range);
+        REQUIRE_THROWS_AS(fixed.computeThetaVisible(outOfRange, dataVisible), std::out_of_range);
+
+        arma::rowvec shortVisible = {1, 1};
+        dataVisible["E0"] = shortVisible;
+
+        REQUIRE_THROWS_AS(fixed.computeThetaVisible(dataHidden, dataVisible), std::out_of_range);
+
+        BayesianNetworkFixed<3>::distribution fixedThetaHidden = {0.25, 0.40, 0.35};
+        arma::mat thetaVisible = { {0.33, 0.40},
+                                   {0.65, 0.20} };
+
+        REQUIRE_THROWS_AS(fixed.imputeHiddenNode(fixedThetaHidden, thetaVisible), std::invalid_argument);
+
+    }
+}
@@ -49,6 +49,335 @@ TEST_CASE("Connect factors with histogram", "[bayesNet]") {
 
 }
 
+TEST_CASE("Load structure", "[bayesNet]") {
+
+    BayesianNetwork bayesNet(3);
+
+    std::vector<std::string> factors = {"T", "E0", "E1"};
+    std::vector<std::pair<std::string, std::string>> connections = { {"T", "E0"},
+                                                                      {"T", "E1"} };
+
+    REQUIRE(bayesNet.loadStructure(factors, connections));
+
+    REQUIRE(!bayesNet.erase("T", "E0", 0, 0));
+    REQUIRE(bayesNet.record("T", "E0", 0, 0));
+    REQUIRE(bayesNet.erase("T", "E0", 0, 0));
+
+    REQUIRE(bayesNet.computeThetaVisible("T").size() == 2);
+
+}
+
+TEST_CASE("Size tables to the states of each factor", "[bayesNet]") {
+
+    BayesianNetwork bayesNet;
+
+    REQUIRE(bayesNet.add("T", 4));
+    REQUIRE(bayesNet.add("E0"));
+    REQUIRE(!bayesNet.add("E0", 3));
+
+    REQUIRE(bayesNet.getNumStates("T") == 4);
+    REQUIRE(bayesNet.getNumStates("E0") == 2);
+
+    REQUIRE(bayesNet.record("T", "E0", 3, 1));
+
+    std::map<std::string, arma::mat> thetaVisible = bayesNet.computeThetaVisible("T");
+
+    REQUIRE(thetaVisible["E0"].n_rows == 2);
+    REQUIRE(thetaVisible["E0"].n_cols == 4);
+
+    arma::rowvec dataHidden = {0, 3, 3, 1};
+    std::map<std::string, arma::rowvec> dataVisible = { {"E0", {1, 0, 0, 1}} };
+
+    REQUIRE(bayesNet.computeThetaHidden("T", dataHidden).n_elem == 4);
+
+    thetaVisible = bayesNet.computeThetaVisible("T", dataHidden, dataVisible);
+
+    REQUIRE(thetaVisible["E0"].n_rows == 2);
+    REQUIRE(thetaVisible["E0"].n_cols == 4);
+    REQUIRE(thetaVisible["E0"](0, 3) == Approx(1));
+
+    REQUIRE(bayesNet.setParents("E0", {"T"}));
+    REQUIRE(bayesNet.getTable(nodeId{1})->getNumAssignments() == 4);
+
+    REQUIRE(bayesNet.getNumStates(nodeId{2}) == 0);
+    REQUIRE(!bayesNet.record(nodeId{0}, nodeId{2}, 0, 0));
+    REQUIRE(!bayesNet.recordBatch(nodeId{2}, nodeId{0}, NULL, NULL, 0));
+
+}
+
+TEST_CASE("Count data points on several threads", "[bayesNet]") {
+
+    BayesianNetwork bayesNet(3);
+    addFactors(&bayesNet);
+
+    const arma::uword SAMPLES = 300000;
+
+    arma::rowvec dataHidden(SAMPLES);
+    std::map<std::string, arma::rowvec> dataVisible = { {"E0", arma::rowvec(SAMPLES)},
+                                                        {"E1", arma::rowvec(SAMPLES)} };
+
+    for (arma::uword i = 0; i < SAMPLES; ++i) {
+        dataHidden(i) = (i * 7) % 3;
+        dataVisible["E0"](i) = (i / 5) % 3;
+        dataVisible["E1"](i) = (i * i) % 3;
+    }
+
+    bayesNet.setNumThreads(1);
+    std::map<std::string, arma::mat> serial = bayesNet.computeThetaVisible("T", dataHidden, dataVisible);
+
+    bayesNet.setNumThreads(3);
+    REQUIRE(bayesNet.getNumThreads() == 3);
+    std::map<std::string, arma::mat> threaded = bayesNet.computeThetaVisible("T", dataHidden, dataVisible);
+
+    REQUIRE(threaded.size() == serial.size());
+
+    for (auto const& it : serial) {
+        for (arma::uword j = 0; j < it.second.n_elem; ++j) {
+            REQUIRE(threaded[it.first](j) == it.second(j));
+        }
+    }
+
+}
+
+TEST_CASE("Record observations in batches", "[bayesNet]") {
+
+    BayesianNetwork batched(3), single(3);
+
+    REQUIRE(batched.loadStructure({"T", "E0", "E1"}, {{"T", "E0"}, {"T", "E1"}}));
+    REQUIRE(single.loadStructure({"T", "E0", "E1"}, {{"T", "E0"}, {"T", "E1"}}));
+
+    arma::umat states = { {0, 1, 2},
+                          {2, 2, 0},
+                          {1, 1, 1},
+                          {2, 0, 0},
+                          {0, 1, 2} };
+
+    for (arma::uword i = 0; i < states.n_rows; ++i) {
+        REQUIRE(single.record("T", "E0", states(i, 0), states(i, 1)));
+        REQUIRE(single.record("T", "E1", states(i, 0), states(i, 2)));
+    }
+
+    SECTION("Of one edge") {
+
+        REQUIRE(batched.recordBatch("T", "E0", states.colptr(0), states.colptr(1), states.n_rows));
+        REQUIRE(batched.recordBatch("T", "E1", states.colptr(0), states.colptr(2), states.n_rows));
+
+    }
+
+    SECTION("Of every edge between several factors") {
+
+        arma::umat reordered = { {2, 0, 1},
+                                 {0, 2, 2},
+                                 {1, 1, 1},
+                                 {0, 2, 0},
+                                 {2, 0, 1} };
+
+        REQUIRE(batched.recordBatch({"E1", "T", "E0"}, reordered));
+
+    }
+
+    std::map<std::string, arma::mat> expected = single.computeThetaVisible("T");
+    std::map<std::string, arma::mat> actual = batched.computeThetaVisible("T");
+
+    for (auto const& it : expected) {
+        for (arma::uword j = 0; j < it.second.n_elem; ++j) {
+            REQUIRE(actual[it.first](j) == it.second(j));
+        }
+    }
+
+    std::vector<std::string> factors = {"T", "E0", "E1"};
+    arma::umat outOfRange = { {0, 3, 0} };
+
+    REQUIRE(!batched.recordBatch(factors, outOfRange));
+    REQUIRE(!batched.recordBatch(std::vector<std::string>(factors.begin(), factors.begin() + 2), states));
+    REQUIRE(batched.computeThetaVisible("T")["E0"](0, 2) == actual["E0"](0, 2));
+
+}
+
+TEST_CASE("Forget old observations", "[bayesNet]") {
+
+    BayesianNetwork bayesNet;
+
+    REQUIRE(bayesNet.loadStructure({"T", "E0"}, {{"T", "E0"}}));
+
+    nodeId t, e0;
+
+    REQUIRE(bayesNet.getId("T", t));
+    REQUIRE(bayesNet.getId("E0", e0));
+
+    std::map<std::string, arma::uword> visibleStates = { {"E0", 0} };
+
+    SECTION("Decay with a half life") {
+
+        bayesNet.setHalfLife(2);
+
+        REQUIRE(bayesNet.record(t, e0, 0, 0));
+        bayesNet.tick();
+        bayesNet.tick();
+        REQUIRE(bayesNet.record(t, e0, 0, 1));
+
+        REQUIRE(bayesNet.get("T", visibleStates)(0, 0) == Approx(0.5));
+        REQUIRE((*bayesNet.computeThetaVisible(t, e0))(1, 0) == Approx(2.0 / 3));
+
+        REQUIRE(bayesNet.erase(t, e0, 0, 1));
+        REQUIRE((*bayesNet.computeThetaVisible(t, e0))(0, 0) == Approx(1));
+
+        SECTION("Erase only what an observation recorded now is worth") {
+
+            /*
+             * The observation from two ticks ago is worth half of a
+             * new one, so it cannot be taken back on its own.
+             */
+            REQUIRE(!bayesNet.erase(t, e0, 0, 0));
+            REQUIRE(bayesNet.get("T", visibleStates)(0, 0) == Approx(0.5));
+
+            REQUIRE(bayesNet.record(t, e0, 0, 0));
+            REQUIRE(bayesNet.erase(t, e0, 0, 0));
+            REQUIRE(bayesNet.get("T", visibleStates)(0, 0) == Approx(0.5));
+
+            /*
+             * Older observations that add up to more than a new one
+             * give up that much weight between them.
+             */
+            REQUIRE(bayesNet.record(t, e0, 0, 0));
+            REQUIRE(bayesNet.record(t, e0, 0, 0));
+            bayesNet.tick();
+            bayesNet.tick();
+
+            REQUIRE(bayesNet.get("T", visibleStates)(0, 0) == Approx(1.25));
+            REQUIRE(bayesNet.erase(t, e0, 0, 0));
+            REQUIRE(bayesNet.get("T", visibleStates)(0, 0) == Approx(0.25));
+
+        }
+
+        SECTION("Scale counts down before they overflow") {
+
+            bayesNet.setHalfLife(0.5);
+
+            for (int i = 0; i < 2000; ++i) {
+                bayesNet.tick();
+            }
+
+            REQUIRE(bayesNet.record(t, e0, 1, 1));
+            REQUIRE(bayesNet.record(t, e0, 1, 0));
+            bayesNet.tick();
+            REQUIRE(bayesNet.record(t, e0, 1, 1));
+
+            REQUIRE(bayesNet.get("T", visibleStates)(0, 1) == Approx(0.25));
+            REQUIRE((*bayesNet.computeThetaVisible(t, e0))(1, 1) == Approx(5.0 / 6));
+
+        }
+    }
+
+    SECTION("Keep a sliding window") {
+
+        REQUIRE(bayesNet.record(t, e0, 0, 0));
+
+        bayesNet.setWindow(2);
+        REQUIRE(bayesNet.getWindow() == 2);
+
+        bayesNet.tick();
+        REQUIRE(bayesNet.record("T", "E1", 0, 0) == false);
+        REQUIRE(bayesNet.add("E1"));
+        REQUIRE(bayesNet.record("T", "E1", 0, 0));
+        REQUIRE(bayesNet.record(t, e0, 0, 1));
+
+        REQUIRE(bayesNet.get("T", visibleStates)(0, 0) == 1);
+
+        bayesNet.tick();
+
+        visibleStates = { {"E0", 0}, {"E1", 0} };
+
+        REQUIRE(bayesNet.get("T", visibleStates)(0, 0) == 0);
+        REQUIRE(bayesNet.get("T", visibleStates)(1, 0) == 1);
+
+        bayesNet.tick();
+
+        REQUIRE(bayesNet.get("T", visibleStates)(1, 0) == 0);
+
+    }
+
+    SECTION("Keep assigned values as they are") {
+
+        REQUIRE(bayesNet.add("E1"));
+        REQUIRE(bayesNet.record("T", "E1", 0, 0, 0.5));
+
+        bayesNet.setHalfLife(2);
+        bayesNet.setWindow(2);
+
+        for (int i = 0; i < 3; ++i) {
+            bayesNet.tick();
+        }
+
+        REQUIRE(bayesNet.record(t, e0, 0, 0));
+
+        visibleStates = { {"E0", 0}, {"E1", 0} };
+
+        REQUIRE(bayesNet.get("T", visibleStates)(0, 0) == Approx(1));
+        REQUIRE(bayesNet.get("T", visibleStates)(1, 0) == Approx(0.5));
+
+    }
+}
+
+TEST_CASE("Tie parameters of edges", "[bayesNet]") {
+
+    BayesianNetwork bayesNet;
+
+    REQUIRE(bayesNet.loadStructure({"T0", "E0", "T1", "E1", "T2"}, {{"T0", "E0"}, {"T0", "E0"}, {"T0", "X"}}) == false);
+    REQUIRE(bayesNet.getNumTables() == 1);
+
+    REQUIRE(!bayesNet.loadStructure({}, {{"T1", "T2"}, {"T2", "T1"}}));
+    REQUIRE(bayesNet.getNumTables() == 1);
+
+    REQUIRE(bayesNet.add("Y", 3));
+
+    REQUIRE(bayesNet.tie("T1", "E1", "T0", "E0"));
+    REQUIRE(bayesNet.getNumTables() == 1);
+
+    REQUIRE(!bayesNet.tie("T2", "E1", "T1", "T2"));
+    REQUIRE(!bayesNet.tie("T2", "Y", "T0", "E0"));
+    REQUIRE(!bayesNet.tie("E1", "T1", "T0", "E0"));
+
+    REQUIRE(bayesNet.record("T0", "E0", 0, 1));
+    REQUIRE(bayesNet.record("T1", "E1", 0, 1));
+    REQUIRE(bayesNet.record("T1", "E1", 1, 0));
+
+    std::map<std::string, arma::uword> visibleStates = { {"E0", 1} };
+
+    REQUIRE(bayesNet.get("T0", visibleStates)(0, 0) == 2);
+
+    nodeId t0, e0, t1, e1;
+
+    REQUIRE(bayesNet.getId("T0", t0));
+    REQUIRE(bayesNet.getId("E0", e0));
+    REQUIRE(bayesNet.getId("T1", t1));
+    REQUIRE(bayesNet.getId("E1", e1));
+
+    REQUIRE(bayesNet.computeThetaVisible(t0, e0) == bayesNet.computeThetaVisible(t1, e1));
+    REQUIRE((*bayesNet.computeThetaVisible(t1, e1))(1, 0) == Approx(1));
+
+    SECTION("Erasing through a tied edge") {
+
+        REQUIRE(bayesNet.erase("T1", "E1", 0, 1));
+        REQUIRE(bayesNet.erase("T0", "E0", 0, 1));
+        REQUIRE(!bayesNet.erase("T1", "E1", 0, 1));
+
+    }
+
+    SECTION("Tying an edge that has its own table") {
+
+        REQUIRE(bayesNet.record("T2", "E1", 0, 0));
+        REQUIRE(bayesNet.getNumTables() == 2);
+
+        REQUIRE(bayesNet.tie("T2", "E1", "T0", "E0"));
+        REQUIRE(bayesNet.getNumTables() == 1);
+
+        REQUIRE(bayesNet.record("Y", "E1", 2, 0));
+        REQUIRE(bayesNet.getNumTables() == 2);
+
+    }
+}
+
 TEST_CASE("Erase", "[bayesNet") {
 
     auto* bayesNet = new BayesianNetwork(3);
@@ -106,6 +435,124 @@ TEST_CASE("Get probabilities", "[bayesNet]") {
     });
 }
 
+TEST_CASE("Get probabilities of connected factors only", "[bayesNet]") {
+
+    BayesianNetwork bayesNet;
+    addFactors(&bayesNet);
+
+    REQUIRE(bayesNet.record("T", "E0", 1, 0));
+
+    std::map<std::string, arma::uword> query = { {"E0", 0},
+                                                 {"E2", 1},
+                                                 {"X", 0} };
+
+    arma::mat result = bayesNet.get("T", query);
+
+    REQUIRE(result.n_rows == 1);
+    REQUIRE(result(0, 1) == 1);
+
+    query = { {"E0", 2} };
+
+    REQUIRE_THROWS_AS(bayesNet.get("T", query), std::out_of_range);
+
+}
+
+TEST_CASE("Impute hidden node in log space", "[bayesNet]") {
+
+    BayesianNetwork bayesNet;
+
+    arma::rowvec thetaHidden = {0.25, 0.75};
+    arma::mat thetaVisible = { {0.33, 0.40},
+                               {0.65, 0.20} };
+
+    SECTION("Matches the linear kernel") {
+
+        arma::rowvec linear = bayesNet.imputeHiddenNode(thetaHidden, thetaVisible);
+        arma::rowvec logarithmic = bayesNet.imputeHiddenNodeLog(arma::log(thetaHidden), arma::log(thetaVisible));
+
+        REQUIRE(logarithmic(0) == Approx(linear(0)));
+        REQUIRE(logarithmic(1) == Approx(linear(1)));
+
+    }
+
+    SECTION("Gives the posterior with more than two hidden states") {
+
+        arma::rowvec threeHidden = {0.2, 0.5, 0.3};
+        arma::mat threeVisible = { {0.1, 0.6, 0.3},
+                                   {0.5, 0.2, 0.4} };
+
+        /*
+         * Proportional to 0.2 * 0.1 * 0.5, 0.5 * 0.6 * 0.2 and
+         * 0.3 * 0.3 * 0.4, that is 0.01, 0.06 and 0.036.
+         */
+        arma::rowvec logarithmic = bayesNet.imputeHiddenNodeLog(arma::log(threeHidden), arma::log(threeVisible));
+
+        REQUIRE(logarithmic(0) == Approx(0.01 / 0.106));
+        REQUIRE(logarithmic(1) == Approx(0.06 / 0.106));
+        REQUIRE(logarithmic(2) == Approx(0.036 / 0.106));
+
+        /*
+         * The linear kernel weighs the other columns by rotated hidden
+         * probabilities, which only lines up with them for the first
+         * state or when every hidden state is equally likely.
+         */
+        arma::rowvec linear = bayesNet.imputeHiddenNode(threeHidden, threeVisible);
+
+        REQUIRE(linear(0) == Approx(logarithmic(0)));
+        REQUIRE(linear(1) != Approx(logarithmic(1)));
+
+        arma::rowvec uniform = {1.0 / 3, 1.0 / 3, 1.0 / 3};
+
+        linear = bayesNet.imputeHiddenNode(uniform, threeVisible);
+        logarithmic = bayesNet.imputeHiddenNodeLog(arma::log(uniform), arma::log(threeVisible));
+
+        for (arma::uword i = 0; i < 3; ++i) {
+            REQUIRE(linear(i) == Approx(logarithmic(i)));
+        }
+    }
+
+    SECTION("Does not underflow with thousands of visible nodes") {
+
+        arma::mat manyVisible(5000, 2);
+
+        for (arma::uword i = 0; i < manyVisible.n_rows; ++i) {
+            manyVisible(i, 0) = 0.1;
+            manyVisible(i, 1) = 0.2;
+        }
+
+        arma::rowvec final = bayesNet.imputeHiddenNodeLog(arma::log(thetaHidden), arma::log(manyVisible));
+
+        REQUIRE(final(0) == Approx(0));
+        REQUIRE(final(1) == Approx(1));
+
+    }
+
+    SECTION("Works the same in single precision") {
+
+        arma::frowvec final;
+
+        bayesNet.imputeHiddenNodeLog(arma::conv_to<arma::frowvec>::from(arma::log(thetaHidden)),
+                                     arma::conv_to<arma::fmat>::from(arma::log(thetaVisible)), final);
+
+        arma::rowvec reference = bayesNet.imputeHiddenNode(thetaHidden, thetaVisible);
+
+        REQUIRE(final(0) == Approx(reference(0)).epsilon(1e-5));
+        REQUIRE(final(1) == Approx(reference(1)).epsilon(1e-5));
+
+    }
+
+    SECTION("Is all zero when no state fits the evidence") {
+
+        arma::mat impossible = { {0.0, 0.0} };
+
+        arma::rowvec final = bayesNet.imputeHiddenNodeLog(arma::log(thetaHidden), arma::log(impossible));
+
+        REQUIRE(final(0) == 0);
+        REQUIRE(final(1) == 0);
+
+    }
+}
+
 TEST_CASE("Simulate data according to custom distributions", "[bayesNet") {
 
     BayesianNetwork* bayesNet = new BayesianNetwork(3);
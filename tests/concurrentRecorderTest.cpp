@@ -0,0 +1,186 @@
+#include "catch.h"
+#include "armadillo"
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../bayesNet/BayesianNetwork.h"
+#include "../bayesNet/ConcurrentRecorder.h"
+
+TEST_CASE("Record from several threads at once", "[concurrent]") {
+
+    BayesianNetwork bayesNet(3);
+
+    REQUIRE(bayesNet.loadStructure({"T", "E0", "E1", "E2"}, {{"T", "E0"}, {"T", "E1"}}));
+    REQUIRE(bayesNet.record("T", "E0", 2, 2));
+    REQUIRE(bayesNet.tie("E1", "E2", "T", "E0"));
+
+    ConcurrentRecorder recorder(bayesNet);
+
+    REQUIRE(!recorder.record("E0", "T", 0, 0));
+    REQUIRE(!recorder.record("T", "E0", 3, 0));
+    REQUIRE(!recorder.record("T", "X", 0, 0));
+
+    const int THREADS = 4;
+    const int OBSERVATIONS = 20000;
+
+    std::atomic<bool> recorded(true);
+    std::atomic<int> finished(0);
+    std::vector<std::thread> producers;
+
+    for (int t = 0; t < THREADS; ++t) {
+        producers.emplace_back([&recorder, &recorded, &finished, t] () {
+
+            for (int i = 0; i < OBSERVATIONS; ++i) {
+                recorded = recorded & recorder.record("T", "E0", i % 3, (i + t) % 3);
+                recorded = recorded & recorder.record("T", "E1", 0, i % 2);
+                recorded = recorded & recorder.record("E1", "E2", 1, 1);
+            }
+
+            ++finished;
+
+        });
+    }
+
+    /*
+     * Publish while the producers are running. Counts only ever grow
+     * from one snapshot to the next.
+     */
+    double published = 0;
+
+    while (finished < THREADS) {
+
+        recorder.publish();
+
+        std::map<std::string, arma::uword> visibleStates = { {"E1", 1} };
+        double current = bayesNet.get("T", visibleStates)(0, 0);
+
+        REQUIRE(current >= published);
+
+        published = current;
+
+    }
+
+    for (auto& it : producers) {
+        it.join();
+    }
+
+    recorder.publish();
+
+    REQUIRE(recorded);
+
+    std::map<std::string, arma::uword> visibleStates = { {"E0", 1}, {"E1", 0} };
+    arma::mat counts = bayesNet.get("T", visibleStates);
+
+    double expected = 0;
+    double shared = THREADS * OBSERVATIONS;
+
+    for (int t = 0; t < THREADS; ++t) {
+        for (int i = 0; i < OBSERVATIONS; ++i) {
+            expected += (i % 3 == 0 && (i + t) % 3 == 1);
+            shared += (i % 3 == 1 && (i + t) % 3 == 1);
+        }
+    }
+
+    REQUIRE(counts(0, 0) == expected);
+    REQUIRE(counts(1, 0) == THREADS * OBSERVATIONS / 2);
+
+    visibleStates = { {"E2", 1} };
+
+    REQUIRE(bayesNet.get("E1", visibleStates)(0, 1) == shared);
+
+}
+
+TEST_CASE("Read snapshots while publishing", "[concurrent]") {
+
+    BayesianNetwork bayesNet(3);
+
+    REQUIRE(bayesNet.loadStructure({"T", "E0"}, {{"T", "E0"}}));
+    REQUIRE(bayesNet.record("T", "E0", 2, 2));
+
+    nodeId hidden, visible;
+
+    bayesNet.getId("T", hidden);
+    bayesNet.getId("E0", visible);
+
+    ConcurrentRecorder recorder(bayesNet);
+    std::shared_ptr<const ConcurrentRecorder::Snapshot> first = recorder.getSnapshot();
+
+    REQUIRE(first->getEpoch() == 0);
+    REQUIRE(first->getProbabilities(visible, hidden) == NULL);
+    REQUIRE((*first->getProbabilities(hidden, visible))(2, 2) == 1);
+
+    const int THREADS = 4;
+    const int OBSERVATIONS = 20000;
+
+    std::atomic<int> finished(0);
+    std::atomic<bool> consistent(true);
+    std::vector<std::thread> threads;
+
+    for (int t = 0; t < THREADS; ++t) {
+        threads.emplace_back([&recorder, &finished, t] () {
+
+            for (int i = 0; i < OBSERVATIONS; ++i) {
+                recorder.record("T", "E0", i % 3, (i + t) % 3);
+            }
+
+            ++finished;
+
+        });
+    }
+
+    /*
+     * Snapshots only ever move forward, and every column of a table in
+     * one is a distribution, however far publish has got meanwhile.
+     */
+    threads.emplace_back([&recorder, &finished, &consistent, hidden, visible] () {
+
+        uint64_t last = 0;
+
+        while (finished < THREADS) {
+
+            std::shared_ptr<const ConcurrentRecorder::Snapshot> current = recorder.getSnapshot();
+            const probabilityMat& probabilities = *current->getProbabilities(hidden, visible);
+
+            consistent = consistent & (current->getEpoch() >= last);
+            last = current->getEpoch();
+
+            for (arma::uword col = 0; col < probabilities.n_cols; ++col) {
+
+                double total = 0;
+
+                for (arma::uword row = 0; row < probabilities.n_rows; ++row) {
+                    total += probabilities(row, col);
+                }
+
+                consistent = consistent & (total == 0 || std::abs(total - 1) < 1e-6);
+
+            }
+        }
+    });
+
+    while (finished < THREADS) {
+        recorder.publish();
+    }
+
+    for (auto& it : threads) {
+        it.join();
+    }
+
+    recorder.publish();
+
+    std::shared_ptr<const ConcurrentRecorder::Snapshot> last = recorder.getSnapshot();
+
+    REQUIRE(consistent);
+    REQUIRE(last->getEpoch() > first->getEpoch());
+    REQUIRE((*last->getProbabilities(hidden, visible))(0, 0) == Approx(0.5));
+
+    /*
+     * A snapshot held on to is left as it was.
+     */
+    REQUIRE((*first->getProbabilities(hidden, visible))(2, 2) == 1);
+    REQUIRE((*first->getProbabilities(hidden, visible))(0, 0) == 0);
+
+}
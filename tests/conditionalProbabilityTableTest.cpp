@@ -0,0 +1,300 @@
+#include "catch.h"
+#include "armadillo"
+#include <cmath>
+#include <limits>
+
+#include "../bayesNet/BayesianNetwork.h"
+
+TEST_CASE("Lay out conditional probability tables", "[cpt]") {
+
+    ConditionalProbabilityTable table(2, {3, 2});
+
+    REQUIRE(table.getNumParents() == 2);
+    REQUIRE(table.getNumAssignments() == 6);
+    REQUIRE(table.getValues().n_elem == 12);
+
+    SECTION("The first parent varies fastest") {
+
+        REQUIRE(table.offset({0, 0}) == 0);
+        REQUIRE(table.offset({1, 0}) == 2);
+        REQUIRE(table.offset({2, 0}) == 4);
+        REQUIRE(table.offset({0, 1}) == 6);
+        REQUIRE(table.offset({2, 1}) == 10);
+
+    }
+
+    SECTION("Rows are normalized independently") {
+
+        arma::uword seen[] = {1, 1};
+        arma::uword unseen[] = {2, 0};
+
+        table.record(0, seen, 1);
+        table.record(1, seen, 3);
+
+        table.normalize();
+
+        REQUIRE(table.at(0, {1, 1}) == Approx(0.25));
+        REQUIRE(table.at(1, {1, 1}) == Approx(0.75));
+        REQUIRE(table.row(unseen)[0] == 0);
+
+    }
+}
+
+TEST_CASE("Record observations over several parents", "[cpt]") {
+
+    BayesianNetwork bayesNet;
+
+    bayesNet.add("A");
+    bayesNet.add("B");
+    bayesNet.add("C");
+
+    REQUIRE(!bayesNet.setParents("C", {"A", "D"}));
+    REQUIRE(bayesNet.getNumTables() == 0);
+    REQUIRE(bayesNet.setParents("C", {"A", "B"}));
+    REQUIRE(!bayesNet.setParents("A", {"C"}));
+
+    bayesNet.add("D");
+
+    REQUIRE(!bayesNet.setParents("C", {"D"}));
+    REQUIRE(bayesNet.setParents("D", {"B", "C", "A"}));
+    REQUIRE(bayesNet.getNumTables() == 5);
+
+    REQUIRE(!bayesNet.setParents("A", {"B", "D"}));
+    REQUIRE(bayesNet.getNumTables() == 5);
+
+    nodeId c;
+    bayesNet.getId("C", c);
+
+    REQUIRE(bayesNet.record(c, 1, {0, 1}));
+    REQUIRE(bayesNet.record("C", 1, {0, 1}));
+    REQUIRE(bayesNet.record("C", 0, {0, 1}));
+    REQUIRE(!bayesNet.record("C", 2, {0, 1}));
+    REQUIRE(!bayesNet.record("C", 0, {0}));
+    REQUIRE(!bayesNet.record("A", 0, {}));
+
+    REQUIRE(bayesNet.getTable(c)->at(1, {0, 1}) == 2);
+
+    REQUIRE(bayesNet.erase(c, 1, {0, 1}));
+    REQUIRE(!bayesNet.erase(c, 1, {1, 1}));
+
+    REQUIRE(bayesNet.record("C", 1, {1, 1}));
+    REQUIRE(bayesNet.erase("C", 1, {1, 1}));
+    REQUIRE(!bayesNet.erase("C", 1, {1, 1}));
+    REQUIRE(!bayesNet.erase("E", 1, {1, 1}));
+
+    ConditionalProbabilityTable theta = bayesNet.computeThetaConditional("C");
+
+    REQUIRE(theta.at(0, {0, 1}) == Approx(0.5));
+    REQUIRE(theta.at(1, {0, 1}) == Approx(0.5));
+    REQUIRE(theta.at(0, {1, 0}) == 0);
+
+    SECTION("Refuse observations while decaying or windowing") {
+
+        bayesNet.setHalfLife(2);
+
+        REQUIRE(!bayesNet.record(c, 1, {0, 1}));
+        REQUIRE(!bayesNet.erase(c, 0, {0, 1}));
+
+        bayesNet.setHalfLife(0);
+        bayesNet.setWindow(2);
+
+        REQUIRE(!bayesNet.record(c, 1, {0, 1}));
+
+        bayesNet.setWindow(0);
+
+        REQUIRE(bayesNet.record(c, 1, {0, 1}));
+
+    }
+}
+
+TEST_CASE("Normalize counts lazily", "[cpt]") {
+
+    CountTable table(2, 3);
+
+    table.increment(0, 0);
+    table.increment(1, 0);
+    table.increment(1, 2);
+
+    const probabilityMat& probabilities = table.getProbabilities();
+
+    REQUIRE(probabilities(0, 0) == Approx(0.5));
+    REQUIRE(probabilities(1, 0) == Approx(0.5));
+    REQUIRE(probabilities(0, 1) == 0);
+    REQUIRE(probabilities(1, 2) == Approx(1));
+
+    table.increment(0, 2);
+    REQUIRE(table.decrement(1, 0));
+    REQUIRE(!table.decrement(1, 0));
+
+    REQUIRE(table.getCounts()(0, 2) == 1);
+    REQUIRE(table.getProbabilities()(0, 0) == Approx(1));
+    REQUIRE(table.getProbabilities()(1, 2) == Approx(0.5));
+
+}
+
+TEST_CASE("Read probabilities after recording", "[cpt]") {
+
+    BayesianNetwork bayesNet;
+    nodeId hidden, visible;
+
+    bayesNet.add("T", hidden);
+    bayesNet.add("E0", visible);
+
+    REQUIRE(bayesNet.computeThetaVisible(hidden, visible) == NULL);
+
+    REQUIRE(bayesNet.record(hidden, visible, 0, 1));
+
+    const probabilityMat* theta = bayesNet.computeThetaVisible(hidden, visible);
+
+    REQUIRE(theta != NULL);
+    REQUIRE((*theta)(1, 0) == Approx(1));
+
+    REQUIRE(bayesNet.record(hidden, visible, 0, 0));
+
+    theta = bayesNet.computeThetaVisible(hidden, visible);
+
+    REQUIRE((*theta)(0, 0) == Approx(0.5));
+    REQUIRE((*theta)(1, 0) == Approx(0.5));
+    REQUIRE(bayesNet.computeThetaVisible("T")["E0"](0, 0) == Approx(0.5));
+
+}
+
+TEST_CASE("Cache log probabilities", "[cpt]") {
+
+    CountTable table(2, 2);
+
+    table.increment(0, 0);
+    table.increment(1, 0);
+
+    REQUIRE(table.getLogProbabilities()(0, 0) == Approx(std::log(0.5)));
+    REQUIRE(table.getLogProbabilities()(0, 1) == -std::numeric_limits<double>::infinity());
+
+    table.increment(0, 0);
+
+    REQUIRE(table.getProbabilities()(0, 0) == Approx(2.0 / 3));
+    REQUIRE(table.getLogProbabilities()(0, 0) == Approx(std::log(2.0 / 3)));
+
+}
+
+TEST_CASE("Keep counts in a sliding window", "[cpt]") {
+
+    CountTable table(2, 2);
+
+    table.increment(0, 0);
+    table.setWindow(2);
+    table.increment(1, 0);
+
+    table.advance();
+    table.add(1, 1, 0.5);
+
+    REQUIRE(table.getProbabilities()(0, 0) == Approx(0.5));
+
+    table.advance();
+
+    REQUIRE(table.get(0, 0) == 0);
+    REQUIRE(table.get(1, 1) == 0.5);
+    REQUIRE(table.getProbabilities()(1, 0) == 0);
+
+    table.increment(0, 1);
+    table.increment(0, 1);
+    table.advance();
+
+    REQUIRE(table.remove(0, 1, 1));
+    REQUIRE(table.get(0, 1) == 1);
+
+    table.advance();
+
+    REQUIRE(table.get(0, 1) == 0);
+    REQUIRE(!table.decrement(0, 1));
+
+}
+
+TEST_CASE("Combine independent causes with noisy-OR", "[cpt]") {
+
+    BayesianNetwork bayesNet;
+
+    bayesNet.add("Alarm");
+    bayesNet.add("Burglary");
+    bayesNet.add("Earthquake");
+
+    REQUIRE(!bayesNet.setNoisyOr("Alarm", {"Burglary", "Earthquake"}, {0.8}, 0.01));
+    REQUIRE(bayesNet.setNoisyOr("Alarm", {"Burglary", "Earthquake"}, {0.8, 0.6}, 0.01));
+
+    arma::vec none = bayesNet.computeNoisyMax("Alarm", {0, 0});
+    arma::vec both = bayesNet.computeNoisyMax("Alarm", {1, 1});
+    arma::vec one = bayesNet.computeNoisyMax("Alarm", {0, 1});
+
+    REQUIRE(none(1) == Approx(0.01));
+    REQUIRE(both(0) == Approx(0.99 * 0.2 * 0.4));
+    REQUIRE(both(1) == Approx(1 - 0.99 * 0.2 * 0.4));
+    REQUIRE(one(0) == Approx(0.99 * 0.4));
+
+    REQUIRE(bayesNet.computeNoisyMax("Alarm", {1}).n_elem == 0);
+    REQUIRE(bayesNet.computeNoisyMax("Alarm", {0, 2}).n_elem == 0);
+
+    SECTION("Refuse probabilities outside of 0 and 1") {
+
+        REQUIRE(!bayesNet.setNoisyOr("Alarm", {"Burglary", "Earthquake"}, {1.5, 0.6}, 0.01));
+        REQUIRE(!bayesNet.setNoisyOr("Alarm", {"Burglary", "Earthquake"}, {0.8, 0.6}, -0.01));
+        REQUIRE(bayesNet.computeNoisyMax("Alarm", {1, 1})(0) == Approx(0.99 * 0.2 * 0.4));
+
+    }
+
+    SECTION("Refuse edges with a shared table") {
+
+        bayesNet.add("Tremor");
+        REQUIRE(bayesNet.tie("Earthquake", "Tremor", "Earthquake", "Alarm"));
+
+        REQUIRE(!bayesNet.setNoisyOr("Alarm", {"Burglary", "Earthquake"}, {0.8, 0.3}, 0.01));
+        REQUIRE(bayesNet.computeNoisyMax("Alarm", {0, 1})(0) == Approx(0.99 * 0.4));
+
+    }
+
+    SECTION("Refuse parents that raise the factor from state 0") {
+
+        REQUIRE(bayesNet.record("Burglary", "Alarm", 0, 1, 1));
+        REQUIRE(bayesNet.computeNoisyMax("Alarm", {0, 0}).n_elem == 0);
+
+    }
+
+}
+
+TEST_CASE("Combine many causes with noisy-MAX", "[cpt]") {
+
+    BayesianNetwork bayesNet;
+    std::vector<std::string> parents;
+
+    bayesNet.add("Severity", 3);
+
+    for (int i = 0; i < 40; ++i) {
+
+        parents.push_back("Cause" + std::to_string(i));
+        bayesNet.add(parents.back());
+
+        /*
+         * A present cause leaves the severity at 0 with probability
+         * 0.9, raises it to 1 with 0.07 and to 2 with 0.03.
+         */
+        REQUIRE(bayesNet.record(parents.back(), "Severity", 0, 0, 1));
+        REQUIRE(bayesNet.record(parents.back(), "Severity", 1, 0, 0.90));
+        REQUIRE(bayesNet.record(parents.back(), "Severity", 1, 1, 0.07));
+        REQUIRE(bayesNet.record(parents.back(), "Severity", 1, 2, 0.03));
+
+    }
+
+    REQUIRE(!bayesNet.setNoisyMax("Severity", parents, arma::vec({1.0, 0.0})));
+    REQUIRE(!bayesNet.setNoisyMax("Severity", parents, arma::vec({1.2, -0.2, 0.0})));
+    REQUIRE(!bayesNet.setNoisyMax("Severity", parents, arma::vec({0.5, 0.2, 0.1})));
+    REQUIRE(bayesNet.setNoisyMax("Severity", parents, arma::vec({1.0, 0.0, 0.0})));
+
+    nodeId severity;
+    bayesNet.getId("Severity", severity);
+
+    arma::vec distribution;
+    REQUIRE(bayesNet.computeNoisyMax(severity, std::vector<arma::uword>(40, 1), distribution));
+
+    REQUIRE(distribution(0) == Approx(std::pow(0.90, 40)));
+    REQUIRE(distribution(1) == Approx(std::pow(0.97, 40) - std::pow(0.90, 40)));
+    REQUIRE(distribution(2) == Approx(1 - std::pow(0.97, 40)));
+
+}
@@ -0,0 +1,137 @@
+#include "catch.h"
+#include "armadillo"
+
+#include "../bayesNet/BayesianNetwork.h"
+#include "../bayesNet/Dataset.h"
+
+TEST_CASE("Store observations in columns", "[dataset]") {
+
+    Dataset<uint8_t> data(4);
+    arma::uword col;
+
+    REQUIRE(data.addColumn("T", {0, 1, 2, 1}));
+    REQUIRE(!data.addColumn("T", {0, 1, 2, 1}));
+    REQUIRE(!data.addColumn("E0", {0, 1}));
+    REQUIRE(!data.addColumn("E0", {0, 1, 256, 1}));
+    REQUIRE(data.addColumn("E0", col));
+
+    REQUIRE(data.getNumCols() == 2);
+    REQUIRE(data.getMemoryUsage() == 8);
+    REQUIRE(data.getName(col) == "E0");
+    REQUIRE(data.at(3, col) == 0);
+
+    REQUIRE(data.getColumn("T", col));
+    REQUIRE(data.at(2, col) == 2);
+    REQUIRE(data.colptr(col)[1] == 1);
+    REQUIRE(data.toRowvec(col)(2) == 2);
+
+    Dataset<uint16_t> wide(1);
+
+    REQUIRE(wide.addColumn("T", {256}));
+    REQUIRE(wide.getMemoryUsage() == 2);
+
+}
+
+TEST_CASE("Compute probabilities from a dataset", "[dataset]") {
+
+    BayesianNetwork bayesNet(3);
+
+    REQUIRE(bayesNet.loadStructure({"T", "E0", "E1"}, {{"T", "E0"}, {"T", "E1"}}));
+
+    arma::rowvec dataHidden = {0, 1, 2, 1, 1, 0, 2, 2};
+    std::map<std::string, arma::rowvec> dataVisible = { {"E0", {1, 1, 0, 2, 1, 0, 0, 1}},
+                                                        {"E1", {0, 2, 2, 2, 1, 0, 1, 0}} };
+
+    Dataset<uint8_t> data(dataHidden.n_elem);
+
+    REQUIRE(data.addColumn("T", dataHidden));
+    REQUIRE(data.addColumn("E0", dataVisible["E0"]));
+    REQUIRE(data.addColumn("E1", dataVisible["E1"]));
+
+    arma::rowvec thetaHidden = bayesNet.computeThetaHidden("T", dataHidden);
+    arma::rowvec fromDataset = bayesNet.computeThetaHidden("T", data);
+
+    REQUIRE(fromDataset.n_elem == thetaHidden.n_elem);
+
+    for (arma::uword i = 0; i < thetaHidden.n_elem; ++i) {
+        REQUIRE(fromDataset(i) == Approx(thetaHidden(i)));
+    }
+
+    std::map<std::string, arma::mat> thetaVisible = bayesNet.computeThetaVisible("T", dataHidden, dataVisible);
+    std::map<std::string, arma::mat> visibleFromDataset = bayesNet.computeThetaVisible("T", data);
+
+    REQUIRE(visibleFromDataset.size() == 2);
+
+    for (auto const& it : thetaVisible) {
+        for (arma::uword j = 0; j < it.second.n_elem; ++j) {
+            REQUIRE(visibleFromDataset[it.first](j) == Approx(it.second(j)));
+        }
+    }
+
+    SECTION("Impute the hidden node for every observation") {
+
+        arma::mat final;
+        REQUIRE(bayesNet.imputeHiddenNode(thetaHidden, thetaVisible, data, final));
+
+        REQUIRE(final.n_rows == data.getNumRows());
+
+        for (arma::uword i = 0; i < data.getNumRows(); ++i) {
+
+            arma::mat evidence = { {thetaVisible["E0"](data.at(i, 1), 0), thetaVisible["E0"](data.at(i, 1), 1), thetaVisible["E0"](data.at(i, 1), 2)},
+                                   {thetaVisible["E1"](data.at(i, 2), 0), thetaVisible["E1"](data.at(i, 2), 1), thetaVisible["E1"](data.at(i, 2), 2)} };
+
+            arma::rowvec expected = bayesNet.imputeHiddenNodeLog(arma::log(thetaHidden), arma::log(evidence));
+
+            for (arma::uword j = 0; j < expected.n_elem; ++j) {
+                REQUIRE(final(i, j) == Approx(expected(j)));
+            }
+        }
+    }
+
+    SECTION("Skip factors with values out of range") {
+
+        Dataset<uint8_t> outOfRange(2);
+
+        REQUIRE(outOfRange.addColumn("T", {0, 1}));
+        REQUIRE(outOfRange.addColumn("E0", {0, 3}));
+
+        REQUIRE(bayesNet.computeThetaVisible("T", outOfRange).empty());
+        REQUIRE(bayesNet.computeThetaHidden("E0", outOfRange).empty());
+
+        arma::mat final;
+
+        REQUIRE(!bayesNet.imputeHiddenNode(thetaHidden, thetaVisible, outOfRange, final));
+        REQUIRE(final.empty());
+        REQUIRE(!bayesNet.imputeHiddenNode(arma::rowvec({0.5, 0.5}), thetaVisible, data, final));
+        REQUIRE(final.empty());
+
+    }
+}
+
+TEST_CASE("Simulate visible data into a dataset", "[dataset]") {
+
+    BayesianNetwork bayesNet(3);
+
+    REQUIRE(bayesNet.loadStructure({"T", "E0"}, {{"T", "E0"}}));
+
+    for (arma::uword state = 0; state < 3; ++state) {
+        REQUIRE(bayesNet.record("T", "E0", state, (state + 1) % 3));
+    }
+
+    Dataset<uint8_t> data(300);
+
+    REQUIRE(!bayesNet.simulateVisibleData("T", data));
+
+    REQUIRE(data.addColumn("T", bayesNet.simulateHiddenData(std::vector<double>({0.2, 0.3, 0.5}), 300)));
+    REQUIRE(bayesNet.simulateVisibleData("T", data));
+
+    arma::uword hidden, visible;
+
+    REQUIRE(data.getColumn("T", hidden));
+    REQUIRE(data.getColumn("E0", visible));
+
+    for (arma::uword i = 0; i < data.getNumRows(); ++i) {
+        REQUIRE(data.at(i, visible) == (data.at(i, hidden) + 1) % 3);
+    }
+
+}
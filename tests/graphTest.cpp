@@ -4,6 +4,7 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.h"
 #include "armadillo"
+#include <random>
 
 #include "../directedGraph/Graph.h"
 
@@ -21,6 +22,54 @@ TEST_CASE("Add data", "[graph]") {
     }
 }
 
+TEST_CASE("Intern data", "[graph]") {
+
+    Graph<std::string, double> graph;
+
+    nodeId first, second, again;
+
+    REQUIRE(graph.add("T", first));
+    REQUIRE(graph.add("E0", second));
+    REQUIRE(first != second);
+
+    SECTION("Adding the same data twice hands out the same id") {
+
+        REQUIRE(!graph.add("T", again));
+        REQUIRE(again == first);
+
+    }
+
+    SECTION("Ids can be looked up and resolved") {
+
+        REQUIRE(graph.getId("E0", again));
+        REQUIRE(again == second);
+        REQUIRE(graph.getData(again) == "E0");
+        REQUIRE(!graph.getId("E1", again));
+
+    }
+
+    SECTION("Id based operations see the same edges as data based ones") {
+
+        REQUIRE(graph.connect(first, second, 0.5));
+
+        double weight = 0;
+        graph.getWeight("T", "E0", weight);
+        REQUIRE(weight == 0.5);
+
+        REQUIRE(graph.connect("T", "E0", 0.25));
+
+        std::map<nodeId, double> weights = graph.getWeights(first);
+        REQUIRE(weights.size() == 1);
+        REQUIRE(weights[second] == 0.25);
+
+        std::vector<nodeId> ordering;
+        graph.topologicalSort(ordering);
+        REQUIRE(ordering.size() == 2);
+        REQUIRE(ordering[0] == first);
+
+    }
+}
+
 TEST_CASE("Connect nodes", "[graph") {
 
     Graph<int, double> graph;
@@ -38,7 +87,7 @@ TEST_CASE("Connect nodes", "[graph") {
 
     SECTION("Nodes are only connected in one direction") {
 
-        REQUIRE(graph.connect(2, 1, 1.0));
+        REQUIRE(!graph.connect(2, 1, 1.0));
         SECTION("Connecting two nodes twice updates weight") {
 
             /*REQUIRE(!graph.connect(1, 2, 1.0));
@@ -46,6 +95,122 @@ TEST_CASE("Connect nodes", "[graph") {
 
         }
     }
+
+    SECTION("Edges closing a cycle are refused") {
+
+        REQUIRE(graph.add(3));
+        REQUIRE(graph.connect(2, 3, 1.0));
+
+        REQUIRE(!graph.connect(3, 1, 1.0));
+        REQUIRE(!graph.connect(3, 3, 1.0));
+        REQUIRE(graph.getWeight(3, 1) == NULL);
+
+        REQUIRE(graph.topologicalSort() == std::vector<int>({1, 2, 3}));
+
+    }
+}
+
+TEST_CASE("Connect nodes in bulk", "[graph]") {
+
+    Graph<int, double> graph;
+
+    for (int i = 1; i <= 4; ++i) {
+        graph.add(i);
+    }
+
+    REQUIRE(graph.connectUnchecked(4, 3, 1.0));
+    REQUIRE(graph.connectUnchecked(3, 2, 1.0));
+    REQUIRE(graph.connectUnchecked(2, 1, 1.0));
+
+    SECTION("Validating orders the graph") {
+
+        REQUIRE(graph.validate());
+        REQUIRE(graph.topologicalSort() == std::vector<int>({4, 3, 2, 1}));
+
+        REQUIRE(!graph.connect(1, 4, 1.0));
+        REQUIRE(graph.connect(4, 1, 1.0));
+
+    }
+
+    SECTION("Validating detects cycles") {
+
+        REQUIRE(graph.connectUnchecked(1, 4, 1.0));
+
+        REQUIRE(!graph.validate());
+        REQUIRE(!graph.connect(4, 2, 1.0));
+
+    }
+}
+
+TEST_CASE("Look up edges of a node with many children", "[graph]") {
+
+    Graph<int, double> graph;
+
+    const int CHILDREN = 1000;
+
+    for (int i = 0; i <= CHILDREN; ++i) {
+        REQUIRE(graph.add(i));
+    }
+
+    for (int i = 1; i <= CHILDREN; ++i) {
+        REQUIRE(graph.connect(0, i, i));
+    }
+
+    for (int i = 1; i <= CHILDREN; ++i) {
+
+        double weight = 0;
+        graph.getWeight(0, i, weight);
+        REQUIRE(weight == i);
+
+    }
+
+    SECTION("Reconnecting updates the weight without adding an edge") {
+
+        REQUIRE(graph.connect(0, 500, -1.0));
+
+        double* weight = graph.getWeight(0, 500);
+        REQUIRE(*weight == -1.0);
+        delete weight;
+
+        REQUIRE(graph.getWeights(0).size() == CHILDREN);
+
+    }
+
+    SECTION("Edges are only found in the direction they were added") {
+        REQUIRE(graph.getWeight(500, 0) == NULL);
+    }
+}
+
+TEST_CASE("Modify weights in place", "[graph]") {
+
+    Graph<int, std::vector<int>> graph;
+
+    graph.add(1);
+    graph.add(2);
+
+    REQUIRE(graph.findWeight(1, 2) == NULL);
+    REQUIRE(!graph.modifyWeight(1, 2, [] (std::vector<int>& weight) { weight.push_back(1); }));
+
+    REQUIRE(graph.connect(1, 2, std::vector<int>(3, 0)));
+
+    REQUIRE(graph.modifyWeight(1, 2, [] (std::vector<int>& weight) { ++weight[1]; }));
+    REQUIRE(graph.modifyWeight(1, 2, [] (std::vector<int>& weight) { ++weight[1]; }));
+
+    std::vector<int>* weight = graph.findWeight(1, 2);
+
+    REQUIRE(weight != NULL);
+    REQUIRE((*weight)[1] == 2);
+
+    SECTION("Changes through the pointer are visible to copies taken later") {
+
+        (*weight)[0] = 7;
+
+        std::vector<int> copy;
+        graph.getWeight(1, 2, copy);
+
+        REQUIRE(copy[0] == 7);
+
+    }
 }
 
 TEST_CASE("Perform topological sort", "[graph]") {
@@ -99,6 +264,296 @@ TEST_CASE("Perform topological sort", "[graph]") {
     }
 }
 
+TEST_CASE("Maintain topological order while connecting", "[graph]") {
+
+    Graph<int, double> graph;
+
+    const int NODES = 200;
+
+    /*
+     * Edges always point from a lower to a higher rank, but ranks
+     * are shuffled relative to the order nodes are added in, so the
+     * maintained order has to be repaired along the way.
+     */
+    std::vector<int> rank(NODES);
+
+    for (int i = 0; i < NODES; ++i) {
+
+        rank[i] = i;
+        graph.add(i);
+
+    }
+
+    std::mt19937 eng(42);
+    std::shuffle(rank.begin(), rank.end(), eng);
+
+    std::uniform_int_distribution<int> dist(0, NODES - 1);
+    std::vector<std::pair<int, int>> edges;
+
+    for (int i = 0; i < 1000; ++i) {
+
+        int first = dist(eng);
+        int second = dist(eng);
+
+        if (rank[first] < rank[second]) {
+
+            REQUIRE(graph.connect(first, second, 1.0));
+            edges.push_back(std::make_pair(first, second));
+
+        }
+    }
+
+    const std::vector<nodeId>& order = graph.topologicalOrder();
+    std::vector<int> position(NODES);
+
+    REQUIRE(order.size() == NODES);
+
+    for (size_t i = 0; i < order.size(); ++i) {
+        position[graph.getData(order[i])] = (int) i;
+    }
+
+    for (auto const& it : edges) {
+        REQUIRE(position[it.first] < position[it.second]);
+    }
+}
+
+TEST_CASE("Iterate parents", "[graph]") {
+
+    Graph<int, double> graph;
+
+    for (int i = 1; i <= 4; ++i) {
+        graph.add(i);
+    }
+
+    graph.connect(1, 4, 1.4);
+    graph.connect(2, 4, 2.4);
+    graph.connect(3, 4, 3.4);
+    graph.connect(1, 2, 1.2);
+
+    std::map<int, double> parents = graph.getParentWeights(4);
+
+    REQUIRE(parents.size() == 3);
+    REQUIRE(parents[1] == 1.4);
+    REQUIRE(parents[2] == 2.4);
+    REQUIRE(parents[3] == 3.4);
+
+    SECTION("Parent weights follow changes to the edges") {
+
+        graph.connect(2, 4, -1.0);
+        graph.connect(2, 3, 2.3);
+
+        REQUIRE(graph.getParentWeights(4)[2] == -1.0);
+        REQUIRE(graph.getParentWeights(3)[2] == 2.3);
+
+    }
+
+    SECTION("Parents are visited in the order they were connected") {
+
+        nodeId last;
+        REQUIRE(graph.getId(4, last));
+
+        std::vector<int> visited;
+
+        graph.forEachParent(last, [&graph, &visited] (nodeId parent, const double&) {
+            visited.push_back(graph.getData(parent));
+        });
+
+        REQUIRE(visited == std::vector<int>({1, 2, 3}));
+
+    }
+
+    SECTION("Nodes without parents have no parent weights") {
+        REQUIRE(graph.getParentWeights(1).empty());
+    }
+}
+
+TEST_CASE("Freeze graph", "[graph]") {
+
+    Graph<int, double> graph;
+
+    for (int i = 1; i <= 5; ++i) {
+        graph.add(i);
+    }
+
+    graph.connect(1, 4, 1.4);
+    graph.connect(1, 2, 1.2);
+    graph.connect(2, 3, 2.3);
+    graph.connect(4, 3, 4.3);
+    graph.connect(3, 5, 3.5);
+
+    FrozenGraph<int, double> frozen = graph.freeze();
+
+    REQUIRE(frozen.size() == 5);
+    REQUIRE(frozen.topologicalSort() == graph.topologicalSort());
+    REQUIRE(frozen.getWeights(1) == graph.getWeights(1));
+
+    nodeId first, third;
+    REQUIRE(frozen.getId(1, first));
+    REQUIRE(frozen.getId(3, third));
+
+    SECTION("Children are iterated in order with their weights") {
+
+        adjacency<double> children = frozen.children(first);
+
+        REQUIRE(children.size() == 2);
+        REQUIRE(frozen.getData(children.target(0)) == 2);
+        REQUIRE(children.weight(0) == 1.2);
+        REQUIRE(frozen.getData(children.target(1)) == 4);
+        REQUIRE(children.weight(1) == 1.4);
+
+    }
+
+    SECTION("Parents are iterated with the weights of their edges") {
+
+        adjacency<double> parents = frozen.parents(third);
+
+        REQUIRE(parents.size() == 2);
+        REQUIRE(frozen.getData(parents.target(0)) == 2);
+        REQUIRE(parents.weight(0) == 2.3);
+        REQUIRE(frozen.getData(parents.target(1)) == 4);
+        REQUIRE(parents.weight(1) == 4.3);
+
+        REQUIRE(frozen.parents(first).empty());
+
+    }
+
+    SECTION("Single edges can be looked up") {
+
+        double weight = 0;
+
+        frozen.getWeight(4, 3, weight);
+        REQUIRE(weight == 4.3);
+        REQUIRE(frozen.findWeight(third, first) == NULL);
+
+    }
+
+    SECTION("The snapshot is not affected by later changes") {
+
+        graph.connect(1, 2, -1.0);
+
+        double weight = 0;
+        frozen.getWeight(1, 2, weight);
+
+        REQUIRE(weight == 1.2);
+
+    }
+}
+
+TEST_CASE("Build graph from an edge list", "[graph]") {
+
+    Graph<int, double> graph;
+
+    std::vector<int> data = {1, 2, 3, 4};
+    std::vector<std::tuple<int, int, double>> edges = { std::make_tuple(3, 4, 3.4),
+                                                        std::make_tuple(1, 3, 1.3),
+                                                        std::make_tuple(2, 3, 2.3),
+                                                        std::make_tuple(1, 2, 1.2),
+                                                        std::make_tuple(1, 3, -1.0) };
+
+    REQUIRE(graph.build(data, edges));
+
+    REQUIRE(graph.getWeights(1).size() == 2);
+    REQUIRE(graph.getWeights(1)[3] == -1.0);
+    REQUIRE(graph.getParentWeights(3).size() == 2);
+    REQUIRE(graph.topologicalSort() == std::vector<int>({1, 2, 3, 4}));
+
+    SECTION("Built graphs keep accepting checked edges") {
+
+        REQUIRE(!graph.connect(4, 1, 1.0));
+        REQUIRE(graph.connect(2, 4, 2.4));
+
+    }
+
+    SECTION("Unknown data and cycles are reported") {
+
+        std::vector<std::tuple<int, int, double>> more = { std::make_tuple(4, 5, 4.5) };
+        REQUIRE(!graph.build(std::vector<int>(), more));
+
+        more = { std::make_tuple(4, 1, 4.1) };
+        REQUIRE(!graph.build(std::vector<int>(), more));
+
+    }
+
+    SECTION("Cyclic builds leave the graph as it was") {
+
+        std::vector<std::tuple<int, int, double>> more = { std::make_tuple(2, 4, 2.4),
+                                                           std::make_tuple(4, 1, 4.1) };
+        REQUIRE(!graph.build(std::vector<int>(), more));
+
+        REQUIRE(graph.getWeight(2, 4) == NULL);
+        REQUIRE(graph.getWeight(4, 1) == NULL);
+        REQUIRE(graph.connect(2, 4, 2.4));
+        REQUIRE(graph.topologicalSort() == std::vector<int>({1, 2, 3, 4}));
+
+    }
+}
+
+TEST_CASE("Allocate graphs from an arena or pool", "[graph]") {
+
+    SECTION("Monotonic arena") {
+
+        MonotonicArena arena(1024);
+
+        {
+            Graph<std::string, double, ArenaAllocator<double>> graph{ArenaAllocator<double>(arena)};
+
+            for (int i = 0; i < 100; ++i) {
+                REQUIRE(graph.add(std::to_string(i)));
+            }
+
+            for (int i = 1; i < 100; ++i) {
+                REQUIRE(graph.connect("0", std::to_string(i), i));
+            }
+
+            REQUIRE(graph.getWeights("0").size() == 99);
+            REQUIRE(graph.getParentWeights("99")["0"] == 99);
+            REQUIRE(graph.topologicalSort().front() == "0");
+
+        }
+
+        arena.release();
+
+    }
+
+    SECTION("Size class pool") {
+
+        SizeClassPool pool;
+
+        Graph<int, double, PoolAllocator<double>> graph{PoolAllocator<double>(pool)};
+
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(graph.add(i));
+        }
+
+        for (int i = 0; i < 99; ++i) {
+            REQUIRE(graph.connect(i, i + 1, i));
+        }
+
+        double weight = 0;
+        graph.getWeight(50, 51, weight);
+
+        REQUIRE(weight == 50);
+        REQUIRE(graph.freeze().topologicalSort() == graph.topologicalSort());
+
+    }
+
+    SECTION("Pools reuse memory that was given back") {
+
+        SizeClassPool pool;
+        PoolAllocator<int> allocator(pool);
+
+        int* first = allocator.allocate(4);
+        allocator.deallocate(first, 4);
+
+        int* second = allocator.allocate(3);
+
+        REQUIRE(first == second);
+
+        allocator.deallocate(second, 3);
+
+    }
+}
+
 TEST_CASE("Test Bayesian operations", "[graph]") {
 
     /*struct edgeData {
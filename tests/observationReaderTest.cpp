@@ -0,0 +1,113 @@
+#include "catch.h"
+#include "armadillo"
+#include <cstdio>
+#include <fstream>
+
+#include "../bayesNet/BayesianNetwork.h"
+#include "../bayesNet/utilities/ObservationReader.h"
+
+static void writeFile(const std::string& path, const std::string& contents) {
+
+    std::ofstream file(path, std::ios::binary);
+    file << contents;
+
+}
+
+TEST_CASE("Read observations from a delimited file", "[reader]") {
+
+    const std::string path = "observationReaderTest.csv";
+
+    BayesianNetwork bayesNet(3);
+    ObservationReader reader;
+
+    REQUIRE(bayesNet.loadStructure({"T", "E0", "E1"}, {{"T", "E0"}, {"T", "E1"}}));
+
+    SECTION("Counts every line in batches") {
+
+        writeFile(path, "E0,id,T,E1\r\n"
+                        "yes,1,low,a\r\n"
+                        "no,2,high,b\r\n"
+                        "\r\n"
+                        "yes,3,high,a\r\n"
+                        "yes,4,mid,c");
+
+        REQUIRE(reader.setStates("T", {"low", "mid", "high"}));
+        REQUIRE(!reader.setStates("T", {"low"}));
+        REQUIRE(!reader.setStates("E1", {"a", "a"}));
+
+        REQUIRE(reader.open(path, ','));
+        REQUIRE(reader.getColumns() == std::vector<std::string>({"E0", "id", "T", "E1"}));
+        REQUIRE(reader.ingest(bayesNet, 3));
+        REQUIRE(reader.getNumRows() == 4);
+
+        REQUIRE(*reader.getStates("E0") == std::vector<std::string>({"yes", "no"}));
+        REQUIRE(*reader.getStates("E1") == std::vector<std::string>({"a", "b", "c"}));
+        REQUIRE(reader.getStates("id") == NULL);
+
+        std::map<std::string, arma::uword> visibleStates = { {"E0", 0}, {"E1", 0} };
+        arma::mat counts = bayesNet.get("T", visibleStates);
+
+        REQUIRE(counts(0, 0) == 1);
+        REQUIRE(counts(0, 1) == 1);
+        REQUIRE(counts(0, 2) == 1);
+        REQUIRE(counts(1, 0) == 1);
+        REQUIRE(counts(1, 1) == 0);
+        REQUIRE(counts(1, 2) == 1);
+
+        SECTION("Keeps the encoding from one file to the next") {
+
+            writeFile(path, "T\tE0\nhigh\tno\n");
+
+            REQUIRE(reader.open(path, '\t'));
+            REQUIRE(reader.ingest(bayesNet));
+            REQUIRE(reader.getNumRows() == 5);
+
+            visibleStates = { {"E0", 1} };
+
+            REQUIRE(bayesNet.get("T", visibleStates)(0, 2) == 2);
+
+        }
+    }
+
+    SECTION("Fails on lines with the wrong number of fields") {
+
+        writeFile(path, "T,E0\nlow,yes\nlow\n");
+
+        REQUIRE(reader.open(path, ','));
+        REQUIRE(!reader.ingest(bayesNet));
+        REQUIRE(reader.getNumRows() == 0);
+        REQUIRE(reader.getStates("T")->empty());
+
+    }
+
+    SECTION("Fails on more values than a factor has states") {
+
+        writeFile(path, "T,E0\na,yes\nb,yes\nc,yes\nd,yes\n");
+
+        REQUIRE(reader.open(path, ','));
+        REQUIRE(!reader.ingest(bayesNet, 2));
+
+        /*
+         * The first batch is recorded and kept, the values only seen
+         * in the failing one are forgotten.
+         */
+        REQUIRE(reader.getNumRows() == 2);
+        REQUIRE(*reader.getStates("T") == std::vector<std::string>({"a", "b"}));
+
+    }
+
+    SECTION("Fails on a column named twice") {
+
+        writeFile(path, "T,E0,T\nlow,yes,high\n");
+
+        REQUIRE(!reader.open(path, ','));
+        REQUIRE(reader.getColumns().empty());
+        REQUIRE(!reader.ingest(bayesNet));
+
+    }
+
+    REQUIRE(!reader.open("missing.csv", ','));
+
+    std::remove(path.c_str());
+
+}
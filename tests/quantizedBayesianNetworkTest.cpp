@@ -0,0 +1,157 @@
+#include "catch.h"
+#include "armadillo"
+#include <cstdint>
+#include <iostream>
+#include <random>
+
+#include "../bayesNet/QuantizedBayesianNetwork.h"
+
+/*
+ * Records random observations between one hidden and a number of
+ * visible factors.
+ */
+void recordRandom(BayesianNetwork& bayesNet, int visibleFactors, int observations) {
+
+    std::mt19937 eng(42);
+    std::uniform_int_distribution<arma::uword> state(0, bayesNet.getNumStates() - 1);
+
+    bayesNet.add("T");
+
+    for (int i = 0; i < visibleFactors; ++i) {
+
+        std::string name = "E" + std::to_string(i);
+        bayesNet.add(name);
+
+        for (int j = 0; j < observations; ++j) {
+            bayesNet.record("T", name, state(eng), state(eng));
+        }
+    }
+}
+
+/*
+ * Largest difference between the probabilities of a network and those
+ * of its quantized copy.
+ */
+template <typename Q>
+double measureError(BayesianNetwork& bayesNet, const QuantizedBayesianNetwork<Q>& quantized) {
+
+    double error = 0;
+
+    for (auto const& it : bayesNet.computeThetaVisible("T")) {
+        for (arma::uword state = 0; state < it.second.n_rows; ++state) {
+
+            arma::mat row = quantized.get("T", { {it.first, state} });
+
+            for (arma::uword col = 0; col < it.second.n_cols; ++col) {
+                error = std::max(error, std::abs(row(0, col) - it.second(state, col)));
+            }
+        }
+    }
+
+    return error;
+
+}
+
+TEST_CASE("Quantize probability tables", "[quantized]") {
+
+    BayesianNetwork bayesNet(3);
+    recordRandom(bayesNet, 10, 50);
+
+    QuantizedBayesianNetwork<uint8_t> bytes(bayesNet);
+    QuantizedBayesianNetwork<uint16_t> words(bayesNet);
+
+    SECTION("Stay within the error bound") {
+
+        REQUIRE(bytes.getErrorBound() <= 0.5 / 255);
+        REQUIRE(words.getErrorBound() <= 0.5 / 65535);
+
+        REQUIRE(measureError(bayesNet, bytes) <= bytes.getErrorBound());
+        REQUIRE(measureError(bayesNet, words) <= words.getErrorBound());
+
+    }
+
+    SECTION("Impute hidden node from quantized tables") {
+
+        arma::rowvec thetaHidden = {0.25, 0.40, 0.35};
+        std::map<std::string, arma::uword> visibleStates = { {"E0", 0},
+                                                             {"E1", 2},
+                                                             {"E2", 1} };
+
+        std::map<std::string, arma::mat> thetaVisible = bayesNet.computeThetaVisible("T");
+        arma::mat evidence = arma::join_cols(arma::join_cols(thetaVisible["E0"].row(0), thetaVisible["E1"].row(2)),
+                                             thetaVisible["E2"].row(1));
+
+        arma::rowvec expected = bayesNet.imputeHiddenNode(thetaHidden, evidence);
+        arma::rowvec result = words.imputeHiddenNode(thetaHidden, "T", visibleStates);
+
+        for (arma::uword i = 0; i < 3; ++i) {
+            REQUIRE(result(i) == Approx(expected(i)).epsilon(1e-3));
+        }
+    }
+
+    SECTION("Simulate visible data from quantized tables") {
+
+        arma::rowvec dataHidden = {0, 1, 2, 2, 1};
+        std::map<std::string, arma::rowvec> dataVisible = bytes.simulateVisibleData("T", dataHidden, dataHidden.n_elem);
+
+        REQUIRE(dataVisible.size() == 10);
+        REQUIRE(dataVisible["E0"].n_elem == dataHidden.n_elem);
+
+    }
+
+    SECTION("States outside the tables are rejected") {
+
+        REQUIRE(words.get("T", { {"E0", 3} }).n_rows == 0);
+
+        arma::rowvec thetaHidden = {0.25, 0.40, 0.35};
+        arma::rowvec tooManyStates = {0.25, 0.25, 0.25, 0.25};
+
+        REQUIRE_THROWS_AS(words.imputeHiddenNode(thetaHidden, "T", { {"E0", 3} }), std::out_of_range);
+        REQUIRE_THROWS_AS(words.imputeHiddenNode(tooManyStates, "T", { {"E0", 0} }), std::out_of_range);
+
+        arma::rowvec dataHidden = {0, 3, 1};
+        arma::rowvec validHidden = {0, 2, 1};
+
+        REQUIRE(bytes.simulateVisibleData("T", dataHidden, dataHidden.n_elem).empty());
+        REQUIRE(bytes.simulateVisibleData("T", validHidden, 1).empty());
+
+    }
+}
+
+TEST_CASE("Cut memory by the ratio of the storage type", "[quantized]") {
+
+    BayesianNetwork bayesNet(8);
+    recordRandom(bayesNet, 10, 20);
+
+    QuantizedBayesianNetwork<uint8_t> bytes(bayesNet);
+    QuantizedBayesianNetwork<uint16_t> words(bayesNet);
+
+    double doubles = 10 * 8 * 8 * sizeof(double);
+
+    // The float scale of every column eats into the saving, so 16 bit
+    // storage falls short of four times less memory on 8 state tables.
+    REQUIRE((doubles / bytes.getMemoryUsage()) == Approx(512.0 / 96));
+    REQUIRE((doubles / words.getMemoryUsage()) == Approx(512.0 / 160));
+
+}
+
+/*
+ * Hidden behind [.] as it prints rather than checks and takes a while
+ * with a thousand factors; run it with the [benchmark] tag.
+ */
+TEST_CASE("Measure quantization error and memory", "[.][benchmark]") {
+
+    BayesianNetwork bayesNet(8);
+    recordRandom(bayesNet, 1000, 200);
+
+    QuantizedBayesianNetwork<uint8_t> bytes(bayesNet);
+    QuantizedBayesianNetwork<uint16_t> words(bayesNet);
+
+    size_t doubles = 1000 * 8 * 8 * sizeof(double);
+
+    std::cout << "uint8:  error " << measureError(bayesNet, bytes) << " (bound " << bytes.getErrorBound() << "), "
+              << (double) doubles / bytes.getMemoryUsage() << "x smaller" << std::endl;
+    std::cout << "uint16: error " << measureError(bayesNet, words) << " (bound " << words.getErrorBound() << "), "
+              << (double) doubles / words.getMemoryUsage() << "x smaller" << std::endl;
+
+}